@@ -20,27 +20,221 @@
  * SOFTWARE.
  */
 
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <limits>
+#include <sstream>
+#include <stdexcept>
 
 #include "board.hh"
+#include "zobrist.hh"
 
-Board::Board(Player first_player, bool elemental) :
+/*
+ * Positions with fewer empty squares than this are searched without consulting
+ * the transposition table, as re-searching them is cheaper than the lookup.
+ */
+static const int TRANSPOSITION_MINIMUM_EMPTY = 3;
+
+template <int Rows, int Columns>
+BasicBoard<Rows, Columns>::BasicBoard(Player first_player, bool elemental) :
 	_current_player(first_player),
 	_elemental(elemental),
+	_catalog(std::make_shared<CardCatalog>()),
 	_unplayed_cards(2),
-	_unplayed_card_counts(2, 5),
-	_squares(Square::create_squares(3, 3))
+	_unplayed_card_counts(2, HAND_SIZE),
+	_squares(Square::create_squares(Rows, Columns)),
+	_empty_count(_squares.size()),
+	_occupied_squares(0),
+	_red_squares(0),
+	_hash((elemental ? Zobrist::elemental() : 0) + (first_player == PLAYER_BLUE ? Zobrist::player() : 0)),
+	_control(nullptr)
 {
 	_initialize_cards();
-	_initialize_moves();
+
+	_evaluator = std::make_shared<Evaluator>(*this);
+}
+
+/*
+ * Copies the game state. The copy shares the immutable parts of the original,
+ * the card catalog and evaluator, and its transposition table if it has one
+ * yet, but has its own squares and moves, so the two can be played and
+ * searched independently, including from different threads. Moves already
+ * played cannot be undone on the copy.
+ */
+template <int Rows, int Columns>
+BasicBoard<Rows, Columns>::BasicBoard(const BasicBoard & other) :
+	_current_player(other._current_player),
+	_elemental(other._elemental),
+	_catalog(other._catalog),
+	_unplayed_cards(2),
+	_unplayed_card_counts(2, HAND_SIZE),
+	_squares(Square::create_squares(Rows, Columns)),
+	_empty_count(_squares.size()),
+	_occupied_squares(0),
+	_red_squares(0),
+	_hash(0),
+	_transposition_table(other._transposition_table),
+	_evaluator(other._evaluator),
+	_control(nullptr)
+{
+	restore(other.snapshot());
+}
+
+template <int Rows, int Columns>
+BasicBoard<Rows, Columns> & BasicBoard<Rows, Columns>::operator=(const BasicBoard & other)
+{
+	if (this != &other)
+	{
+		_transposition_table = other._transposition_table;
+		restore(other.snapshot());
+	}
+
+	return *this;
+}
+
+/*
+ * Returns the board to the state of a newly constructed one, keeping the card
+ * catalog, moves and transposition table. Table entries remain valid, as every
+ * position's hash covers the hands and elements it was reached with.
+ */
+template <int Rows, int Columns>
+void BasicBoard<Rows, Columns>::reset(Player first_player, bool elemental)
+{
+	_current_player = first_player;
+	_elemental = elemental;
+
+	for (auto & unplayed_cards : _unplayed_cards)
+		unplayed_cards.clear();
+
+	_unplayed_card_counts.assign(2, HAND_SIZE);
+
+	for (auto & square : _squares)
+	{
+		square->card = nullptr;
+		square->element = ELEMENT_NONE;
+	}
+
+	_empty_count = _squares.size();
+	_occupied_squares = 0;
+	_red_squares = 0;
+
+	_move_history = std::stack<std::shared_ptr<Move>>();
+	_flip_history = std::stack<std::shared_ptr<Square>>();
+
+	_hash = (elemental ? Zobrist::elemental() : 0) + (first_player == PLAYER_BLUE ? Zobrist::player() : 0);
+}
+
+/*
+ * Throws std::length_error if a hand holds more than HAND_SIZE distinct
+ * cards, as with hands set up by activate_card_level.
+ */
+template <int Rows, int Columns>
+typename BasicBoard<Rows, Columns>::Snapshot BasicBoard<Rows, Columns>::snapshot() const
+{
+	Snapshot snapshot;
+
+	snapshot.current_player = _current_player;
+	snapshot.elemental = _elemental;
+
+	for (int i = 0; i < SQUARES; i++)
+	{
+		snapshot.cards[i] = _squares[i]->card ? _squares[i]->card->index : -1;
+		snapshot.owners[i] = _squares[i]->card ? _squares[i]->owner : PLAYER_RED;
+		snapshot.elements[i] = _squares[i]->element;
+	}
+
+	for (int player = PLAYER_RED; player <= PLAYER_BLUE; player++)
+	{
+		if (_unplayed_cards[player].size() > static_cast<size_t>(HAND_SIZE))
+			throw std::length_error("a hand has too many distinct cards for a snapshot");
+
+		int size = 0;
+
+		for (auto & pair : _unplayed_cards[player])
+		{
+			snapshot.hand_cards[player][size] = pair.first->index;
+			snapshot.hand_counts[player][size] = pair.second;
+			size++;
+		}
+
+		snapshot.hand_sizes[player] = size;
+
+		snapshot.unplayed_card_counts[player] = _unplayed_card_counts[player];
+	}
+
+	snapshot.hash = _hash;
+
+	return snapshot;
+}
+
+/*
+ * Returns to a snapshot's state. This takes time in proportion to the number
+ * of squares and cards in hand, not to the size of the catalog, and discards
+ * the history of moves played.
+ */
+template <int Rows, int Columns>
+void BasicBoard<Rows, Columns>::restore(const Snapshot & snapshot)
+{
+	_current_player = snapshot.current_player;
+	_elemental = snapshot.elemental;
+
+	_empty_count = SQUARES;
+	_occupied_squares = 0;
+	_red_squares = 0;
+
+	for (int i = 0; i < SQUARES; i++)
+	{
+		auto & square = _squares[i];
+
+		square->card = snapshot.cards[i] >= 0 ? _catalog->list[snapshot.cards[i]] : nullptr;
+		square->owner = snapshot.owners[i];
+		square->element = snapshot.elements[i];
+
+		if (square->card)
+		{
+			_empty_count--;
+			_occupied_squares |= 1u << i;
+			_red_squares |= square->owner == PLAYER_RED ? 1u << i : 0;
+		}
+	}
+
+	for (int player = PLAYER_RED; player <= PLAYER_BLUE; player++)
+	{
+		_unplayed_cards[player].clear();
+
+		for (int i = 0; i < snapshot.hand_sizes[player]; i++)
+		{
+			auto & card = _catalog->list[snapshot.hand_cards[player][i]];
+
+			_initialize_moves(card);
+			_unplayed_cards[player][card] = snapshot.hand_counts[player][i];
+		}
+
+		_unplayed_card_counts[player] = snapshot.unplayed_card_counts[player];
+	}
+
+	while (!_move_history.empty())
+		_move_history.pop();
+
+	while (!_flip_history.empty())
+		_flip_history.pop();
+
+	_hash = snapshot.hash;
+}
+
+template <int Rows, int Columns>
+std::shared_ptr<BasicBoard<Rows, Columns>> BasicBoard<Rows, Columns>::fork() const
+{
+	return std::make_shared<BasicBoard>(*this);
 }
 
-bool Board::activate_card(Player player, const std::string & name)
+template <int Rows, int Columns>
+bool BasicBoard<Rows, Columns>::activate_card(Player player, const std::string & name)
 {
-	if (_cards.count(name))
+	if (_catalog->cards.count(name))
 	{
-		_unplayed_cards[player][_cards[name]]++;
+		activate_card(player, _catalog->cards[name]);
 		return true;
 	}
 	else
@@ -49,25 +243,90 @@ bool Board::activate_card(Player player, const std::string & name)
 	}
 }
 
-void Board::activate_card_level(Player player, int level)
+template <int Rows, int Columns>
+void BasicBoard<Rows, Columns>::activate_card(Player player, const std::shared_ptr<Card> & card)
 {
-	for (auto & pair : _cards)
+	_initialize_moves(card);
+
+	_unplayed_cards[player][card]++;
+	_hash += Zobrist::hand(player, card->index);
+}
+
+template <int Rows, int Columns>
+void BasicBoard<Rows, Columns>::activate_card_level(Player player, int level)
+{
+	for (auto & pair : _catalog->cards)
 	{
 		if (pair.second->level == level)
 		{
-			_unplayed_cards[player][pair.second] = 5;
+			_initialize_moves(pair.second);
+
+			int & count = _unplayed_cards[player][pair.second];
+
+			_hash += (HAND_SIZE - count) * Zobrist::hand(player, pair.second->index);
+			count = HAND_SIZE;
 		}
 	}
 }
 
-void Board::set_element(int row, int column, Element element)
+template <int Rows, int Columns>
+void BasicBoard<Rows, Columns>::set_element(int row, int column, Element element)
 {
-	auto square = _squares[row * 3 + column];
+	auto square = _squares[row * Columns + column];
 
+	_hash += Zobrist::element(square->index, element) - Zobrist::element(square->index, square->element);
 	square->element = element;
 }
 
-bool Board::move(const std::shared_ptr<Move> & move, bool output)
+/*
+ * Replaces the board's transposition table, so that several boards, possibly
+ * searching in different threads, can share one. Only boards of the same size
+ * should share a table.
+ */
+template <int Rows, int Columns>
+void BasicBoard<Rows, Columns>::set_transposition_table(const std::shared_ptr<TranspositionTable> & table)
+{
+	_transposition_table = table;
+}
+
+/*
+ * Returns the board's transposition table. A board given none creates a
+ * private one of 2^20 entries here, when it is first needed, so boards that
+ * never search or are given a shared table never map one.
+ */
+template <int Rows, int Columns>
+const std::shared_ptr<TranspositionTable> & BasicBoard<Rows, Columns>::get_transposition_table()
+{
+	if (!_transposition_table)
+		_transposition_table = std::make_shared<TranspositionTable>(20, false);
+
+	return _transposition_table;
+}
+
+/*
+ * Sets the tracer that records the nodes of subsequent minimax searches.
+ * Returns false, ignoring the tracer, unless built with TRIPLETRIAD_TRACE.
+ */
+template <int Rows, int Columns>
+bool BasicBoard<Rows, Columns>::set_tracer(const std::shared_ptr<SearchTracer> & tracer)
+{
+#ifdef TRIPLETRIAD_TRACE
+	_tracer = tracer;
+	return true;
+#else
+	(void)tracer;
+	return false;
+#endif
+}
+
+template <int Rows, int Columns>
+const std::vector<std::shared_ptr<Card>> & BasicBoard<Rows, Columns>::get_cards() const
+{
+	return _catalog->list;
+}
+
+template <int Rows, int Columns>
+bool BasicBoard<Rows, Columns>::move(const std::shared_ptr<Move> & move, bool output)
 {
 	if (move->square->card)
 		return false;
@@ -92,51 +351,255 @@ bool Board::move(const std::shared_ptr<Move> & move, bool output)
 	return true;
 }
 
-Player Board::get_current_player() const
+template <int Rows, int Columns>
+int BasicBoard<Rows, Columns>::get_rows() const
+{
+	return Rows;
+}
+
+template <int Rows, int Columns>
+int BasicBoard<Rows, Columns>::get_columns() const
+{
+	return Columns;
+}
+
+template <int Rows, int Columns>
+Player BasicBoard<Rows, Columns>::get_current_player() const
 {
 	return _current_player;
 }
 
-int Board::get_score(Player player) const
+template <int Rows, int Columns>
+int BasicBoard<Rows, Columns>::get_score(Player player) const
+{
+	uint32_t owned = player == PLAYER_RED ? _red_squares : _occupied_squares & ~_red_squares;
+
+	return _unplayed_card_counts[player] + __builtin_popcount(owned);
+}
+
+template <int Rows, int Columns>
+int BasicBoard<Rows, Columns>::get_score_bound() const
 {
-	int score = _unplayed_card_counts[player];
+	return 2 * HAND_SIZE + 1;
+}
+
+template <int Rows, int Columns>
+int BasicBoard<Rows, Columns>::get_empty_count() const
+{
+	return _empty_count;
+}
 
+template <int Rows, int Columns>
+bool BasicBoard<Rows, Columns>::is_complete() const
+{
 	for (auto & square : _squares)
 	{
-		if (square->card && square->owner == player)
-		{
-			score++;
-		}
+		if (!square->card)
+			return false;
 	}
 
-	return score;
+	return true;
+}
+
+static void _write_bits(uint64_t words[2], int & offset, uint64_t value, int bits)
+{
+	words[offset / 64] |= value << (offset % 64);
+
+	if (offset % 64 + bits > 64)
+		words[offset / 64 + 1] |= value >> (64 - offset % 64);
+
+	offset += bits;
+}
+
+static uint64_t _read_bits(const uint64_t words[2], int & offset, int bits)
+{
+	uint64_t value = words[offset / 64] >> (offset % 64);
+
+	if (offset % 64 + bits > 64)
+		value |= words[offset / 64 + 1] << (64 - offset % 64);
+
+	offset += bits;
+
+	return value & ((static_cast<uint64_t>(1) << bits) - 1);
 }
 
-bool Board::is_complete() const
+/*
+ * Packs the position into the layout described in position.hh. Fails on
+ * boards other than 3x3, or if the hands are too large to fit, as with hands
+ * set up by activate_card_level.
+ */
+template <int Rows, int Columns>
+bool BasicBoard<Rows, Columns>::encode(Position & position) const
 {
+	if (SQUARES != 9)
+		return false;
+
+	uint64_t words[2] = {0, 0};
+	int offset = 0;
+
+	_write_bits(words, offset, _current_player, 1);
+	_write_bits(words, offset, _elemental, 1);
+
+	uint64_t elements = 0;
+	uint64_t occupied = 0;
+
+	for (int i = _squares.size() - 1; i >= 0; i--)
+	{
+		elements = elements * 9 + _squares[i]->element;
+		occupied = (occupied << 1) | (_squares[i]->card ? 1 : 0);
+	}
+
+	_write_bits(words, offset, elements, 29);
+	_write_bits(words, offset, occupied, 9);
+
 	for (auto & square : _squares)
 	{
-		if (!square->card)
-			return false;
+		if (square->card)
+		{
+			_write_bits(words, offset, square->card->index, 7);
+			_write_bits(words, offset, square->owner, 1);
+		}
+	}
+
+	int hands[2][7];
+	int sizes[2] = {0, 0};
+
+	for (int player = PLAYER_RED; player <= PLAYER_BLUE; player++)
+	{
+		for (auto & pair : _unplayed_cards[player])
+		{
+			for (int i = 0; i < pair.second; i++)
+			{
+				if (sizes[player] == 7)
+					return false;
+
+				hands[player][sizes[player]++] = pair.first->index;
+			}
+		}
+
+		std::sort(hands[player], hands[player] + sizes[player]);
+		_write_bits(words, offset, sizes[player], 3);
+	}
+
+	if (offset + 7 * (sizes[PLAYER_RED] + sizes[PLAYER_BLUE]) > 128)
+		return false;
+
+	for (int player = PLAYER_RED; player <= PLAYER_BLUE; player++)
+	{
+		for (int i = 0; i < sizes[player]; i++)
+			_write_bits(words, offset, hands[player][i], 7);
 	}
 
+	position = Position(words[0], words[1]);
+
 	return true;
 }
 
-std::shared_ptr<Move> Board::get_move(int row, int column, const std::string & name)
+/*
+ * Replaces the current state with the encoded position. The cards each player
+ * has left to score are derived from the number of cards placed, assuming full
+ * hands. Fails on boards other than 3x3, and fails leaving the board reset if
+ * the encoding is invalid.
+ */
+template <int Rows, int Columns>
+bool BasicBoard<Rows, Columns>::decode(const Position & position)
 {
-	auto square = _squares[row * 3 + column];
-	return square->moves[_cards[name]];
+	if (SQUARES != 9)
+		return false;
+
+	uint64_t words[2] = {position.low, position.high};
+	int offset = 0;
+
+	Player current_player = static_cast<Player>(_read_bits(words, offset, 1));
+	bool elemental = _read_bits(words, offset, 1);
+
+	reset(current_player, elemental);
+
+	uint64_t elements = _read_bits(words, offset, 29);
+	uint64_t occupied = _read_bits(words, offset, 9);
+
+	for (auto & square : _squares)
+	{
+		Element element = static_cast<Element>(elements % 9);
+		elements /= 9;
+
+		_hash += Zobrist::element(square->index, element);
+		square->element = element;
+	}
+
+	for (auto & square : _squares)
+	{
+		if (occupied & (1 << square->index))
+		{
+			size_t card = _read_bits(words, offset, 7);
+
+			if (card >= _catalog->list.size())
+			{
+				reset(current_player, elemental);
+				return false;
+			}
+
+			square->card = _catalog->list[card];
+			square->owner = static_cast<Player>(_read_bits(words, offset, 1));
+			_occupied_squares |= 1u << square->index;
+			_red_squares |= square->owner == PLAYER_RED ? 1u << square->index : 0;
+			_hash += Zobrist::square(square->index, card, square->owner);
+			_empty_count--;
+		}
+	}
+
+	int sizes[2];
+	sizes[PLAYER_RED] = _read_bits(words, offset, 3);
+	sizes[PLAYER_BLUE] = _read_bits(words, offset, 3);
+
+	if (offset + 7 * (sizes[PLAYER_RED] + sizes[PLAYER_BLUE]) > 128)
+	{
+		reset(current_player, elemental);
+		return false;
+	}
+
+	for (int player = PLAYER_RED; player <= PLAYER_BLUE; player++)
+	{
+		for (int i = 0; i < sizes[player]; i++)
+		{
+			size_t card = _read_bits(words, offset, 7);
+
+			if (card >= _catalog->list.size())
+			{
+				reset(current_player, elemental);
+				return false;
+			}
+
+			activate_card(static_cast<Player>(player), _catalog->list[card]);
+		}
+	}
+
+	int placed = _squares.size() - _empty_count;
+
+	_unplayed_card_counts[current_player] = HAND_SIZE - placed / 2;
+	_unplayed_card_counts[1 - current_player] = HAND_SIZE - (placed - placed / 2);
+
+	return true;
 }
 
-std::shared_ptr<Move> Board::suggest_move()
+template <int Rows, int Columns>
+std::shared_ptr<Move> BasicBoard<Rows, Columns>::get_move(int row, int column, const std::string & name)
 {
-	Player self(_current_player);
+	auto square = _squares[row * Columns + column];
+	auto card = _catalog->cards.find(name);
 
-	int positions = 0;
-	int best_score = std::numeric_limits<int>::min();
+	if (card == _catalog->cards.end())
+		return nullptr;
 
-	std::shared_ptr<Move> best_move;
+	_initialize_moves(card->second);
+
+	return square->moves[card->second];
+}
+
+template <int Rows, int Columns>
+std::vector<std::shared_ptr<Move>> BasicBoard<Rows, Columns>::get_moves()
+{
+	std::vector<std::shared_ptr<Move>> moves;
 
 	for (auto & square : _squares)
 	{
@@ -145,35 +608,391 @@ std::shared_ptr<Move> Board::suggest_move()
 			for (auto & pair : _unplayed_cards[_current_player])
 			{
 				if (pair.second > 0)
-				{
-					std::shared_ptr<Move> move(square->moves.at(pair.first));
+					moves.push_back(square->moves.at(pair.first));
+			}
+		}
+	}
 
-					_move(move, false);
-					int score = _search_minimax(self, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), positions);
-					_unmove();
+	return moves;
+}
 
-					if (score > best_score)
-					{
-						best_score = score;
-						best_move = move;
-					}
+template <int Rows, int Columns>
+int BasicBoard<Rows, Columns>::count_flips(const std::shared_ptr<Move> & move)
+{
+	size_t flips = _flip_history.size();
 
-					positions++;
-				}
+	_move(move, false);
+	flips = _flip_history.size() - flips - 1;
+	_unmove();
+
+	return flips;
+}
+
+/*
+ * Plays out every sequence of moves to the given depth, or to the end of the
+ * game if that is sooner, without searching or evaluating. Counts the leaves
+ * reached and the flips made by the last move into each leaf, which together
+ * check move generation and execution, and time them on their own.
+ */
+template <int Rows, int Columns>
+void BasicBoard<Rows, Columns>::perft(int depth, long & leaves, long & flips)
+{
+	if (depth <= 0 || _empty_count == 0)
+	{
+		leaves++;
+		return;
+	}
+
+	for (auto & square : _squares)
+	{
+		if (square->card)
+			continue;
+
+		for (auto & pair : _unplayed_cards[_current_player])
+		{
+			if (pair.second == 0)
+				continue;
+
+			size_t history = _flip_history.size();
+
+			_move(square->moves.at(pair.first), false);
+
+			if (depth == 1 || _empty_count == 0)
+			{
+				leaves++;
+				flips += _flip_history.size() - history - 1;
 			}
+			else
+				perft(depth - 1, leaves, flips);
+
+			_unmove();
+		}
+	}
+}
+
+template <int Rows, int Columns>
+std::shared_ptr<Move> BasicBoard<Rows, Columns>::suggest_move()
+{
+	return suggest_move(_squares.size());
+}
+
+template <int Rows, int Columns>
+std::shared_ptr<Move> BasicBoard<Rows, Columns>::suggest_move(int depth)
+{
+	int positions = 0;
+	int best_score;
+
+	auto best_move = find_move(depth, best_score, positions);
+
+	std::ostringstream utility;
+
+	if (depth >= _empty_count)
+		utility << best_score;
+	else
+		utility << std::fixed << std::setprecision(2) << static_cast<double>(best_score) / Evaluator::SCALE;
+
+	std::cout << std::left << "COMPUTER: ";
+	std::cout << std::setw(11) << "Positions:" << std::setw(12) << positions;
+	std::cout << std::setw(6) << "Move:" << std::setw(30) << *best_move;
+	std::cout << std::setw(10) << "Utility:" << std::setw(10) << utility.str();
+	std::cout << std::endl;
+
+	return best_move;
+}
+
+/*
+ * Searches the given number of plies ahead and returns the best move. Searches
+ * that cannot reach the end of the game score the positions they stop at with
+ * the static evaluator, in its units of 1/Evaluator::SCALE of a card, and their
+ * results are not stored in the transposition table.
+ */
+template <int Rows, int Columns>
+std::shared_ptr<Move> BasicBoard<Rows, Columns>::find_move(int depth, int & best_score, int & positions)
+{
+	Player self(_current_player);
+
+	int bound = depth >= _empty_count ? get_score_bound() : get_score_bound() * Evaluator::SCALE;
+
+	best_score = -bound;
+
+	std::shared_ptr<Move> best_move;
+
+	auto moves = _order_moves();
+
+	SearchControl * control = _control.load(std::memory_order_relaxed);
+
+	SearchProgress progress;
+	progress.total_moves = moves.size();
+
+	for (auto & move : moves)
+	{
+		int score = _search_root(self, move, depth - 1, best_score, bound, positions);
+
+		if (control && control->is_cancelled())
+			return nullptr;
+
+		if (!best_move || score > best_score)
+		{
+			best_score = score;
+			best_move = move;
+		}
+
+		if (control)
+		{
+			progress.positions = positions;
+			progress.searched_moves++;
+			progress.best_move = best_move;
+			progress.best_score = best_score;
+
+			control->report(progress);
 		}
 	}
 
-	std::cout << std::left << "COMPUTER: ";
-	std::cout << std::setw(11) << "Positions:" << std::setw(12) << positions;
-	std::cout << std::setw(6) << "Move:" << std::setw(30) << *best_move;
-	std::cout << std::setw(10) << "Utility:" << std::setw(10) << best_score;
-	std::cout << std::endl;
+	if (best_move && depth >= get_empty_count())
+		get_transposition_table()->store(_hash, _empty_count, best_score, best_score, best_move->square->index, best_move->card->index);
+
+	return best_move;
+}
+
+/*
+ * Runs find_move on its own thread under the given control. The search plays
+ * moves on the board itself, so the caller must not read, change or search the
+ * board until the future is ready; only starting a second asynchronous search
+ * is checked, and throws std::logic_error. A cancelled search yields nullptr
+ * and leaves the board exactly as it was, with only fully searched positions
+ * kept in the transposition table.
+ */
+template <int Rows, int Columns>
+std::future<std::shared_ptr<Move>> BasicBoard<Rows, Columns>::find_move_async(int depth, const std::shared_ptr<SearchControl> & control)
+{
+	SearchControl * idle = nullptr;
+
+	if (!_control.compare_exchange_strong(idle, control.get()))
+		throw std::logic_error("a search is already running on this board");
+
+	return std::async(std::launch::async, [this, depth, control]() {
+		int best_score = 0;
+		int positions = 0;
+
+		auto best_move = find_move(depth, best_score, positions);
+		_control.store(nullptr);
+
+		SearchProgress progress = control->get_progress();
+		progress.positions = positions;
+		progress.complete = !control->is_cancelled();
+
+		if (best_move)
+		{
+			progress.best_move = best_move;
+			progress.best_score = best_score;
+		}
+
+		control->report(progress);
+
+		return best_move;
+	});
+}
+
+/*
+ * Computes a score for every legal move. Each move is searched with a narrow
+ * window around the previous move's score, which the shared transposition table
+ * makes cheap to re-search when it fails. When exact is false, moves that are
+ * proven worse than the best move found so far are only given an upper bound.
+ */
+template <int Rows, int Columns>
+std::vector<MoveAnalysis> BasicBoard<Rows, Columns>::analyze_moves(bool exact)
+{
+	Player self(_current_player);
+
+	int depth = _squares.size();
+	int positions = 0;
+	int bound = get_score_bound();
+	int best_score = -bound;
+
+	std::vector<MoveAnalysis> analysis;
+
+	for (auto & move : _order_moves())
+	{
+		MoveAnalysis entry;
+		entry.move = move;
+		entry.bound = BOUND_EXACT;
+
+		if (analysis.empty() || exact)
+		{
+			int guess = analysis.empty() ? 0 : analysis.back().score;
+
+			entry.score = _search_root(self, move, depth - 1, guess - 1, guess + 1, positions);
+
+			if (entry.score <= guess - 1)
+				entry.score = _search_root(self, move, depth - 1, -bound, guess, positions);
+			else if (entry.score >= guess + 1)
+				entry.score = _search_root(self, move, depth - 1, guess, bound, positions);
+		}
+		else
+		{
+			entry.score = _search_root(self, move, depth - 1, best_score - 1, best_score, positions);
+
+			if (entry.score >= best_score)
+				entry.score = _search_root(self, move, depth - 1, best_score - 1, bound, positions);
+			else
+				entry.bound = BOUND_UPPER;
+		}
+
+		best_score = std::max(best_score, entry.score);
+		analysis.push_back(entry);
+	}
+
+	std::stable_sort(analysis.begin(), analysis.end(), [](const MoveAnalysis & a, const MoveAnalysis & b) {
+		if (a.score != b.score)
+			return a.score > b.score;
+
+		return a.bound == BOUND_EXACT && b.bound != BOUND_EXACT;
+	});
+
+	if (!analysis.empty())
+		get_transposition_table()->store(_hash, _empty_count, best_score, best_score, analysis[0].move->square->index, analysis[0].move->card->index);
+
+	return analysis;
+}
+
+/*
+ * Determines only whether the current player wins, draws or loses.
+ */
+template <int Rows, int Columns>
+Outcome BasicBoard<Rows, Columns>::solve_outcome()
+{
+	return _solve_outcome(_current_player);
+}
+
+/*
+ * Determines the outcome of every legal move, best first. The searches share
+ * the transposition table, so positions common to several moves are only
+ * decided once.
+ */
+template <int Rows, int Columns>
+std::vector<MoveOutcome> BasicBoard<Rows, Columns>::analyze_outcomes()
+{
+	Player self(_current_player);
+
+	std::vector<MoveOutcome> outcomes;
+
+	for (auto & move : _order_moves())
+	{
+		MoveOutcome entry;
+		entry.move = move;
+
+		_move(move, false);
+		entry.outcome = _solve_outcome(self);
+		_unmove();
+
+		outcomes.push_back(entry);
+	}
+
+	std::stable_sort(outcomes.begin(), outcomes.end(), [](const MoveOutcome & a, const MoveOutcome & b) {
+		return a.outcome > b.outcome;
+	});
+
+	return outcomes;
+}
+
+/*
+ * Searches the current position to the end of the game with a fail-hard
+ * window, returning its score from the perspective of self.
+ */
+template <int Rows, int Columns>
+int BasicBoard<Rows, Columns>::search(Player self, int alpha, int beta, int & positions)
+{
+	return _search_minimax(self, _empty_count, alpha, beta, positions);
+}
+
+/*
+ * Finds the move with the best expected result against an opponent following
+ * the given model, rather than a perfect one. Positions less likely to be
+ * reached than a threshold are scored by the static evaluator instead. The
+ * search is repeated with the threshold halved each time, until it no longer
+ * cuts anything off or a pass runs past budget positions, and the move from
+ * the last complete pass is returned. The first pass, which looks no further
+ * than the opponent's replies, always completes.
+ *
+ * Exact bounds on expected values are kept in the cache, which the caller may
+ * keep between moves of a game as long as the player, model and objective stay
+ * the same.
+ */
+template <int Rows, int Columns>
+std::shared_ptr<Move> BasicBoard<Rows, Columns>::find_move_expectimax(const OpponentModel & model, Objective objective, ExpectimaxCache & cache, int budget, double & value, int & positions)
+{
+	Player self(_current_player);
+
+	double highest = objective == OBJECTIVE_OUTCOME ? 1.0 : get_score_bound() - 1;
+
+	std::shared_ptr<Move> best_move;
+	auto moves = _order_moves();
+
+	for (double minimum_reach = 1.0; ; minimum_reach /= 2.0)
+	{
+		int pass_budget = best_move ? budget : std::numeric_limits<int>::max();
+		bool approximate = false;
+
+		std::shared_ptr<Move> pass_move;
+		double pass_value = -highest - 1.0;
+
+		for (auto & move : moves)
+		{
+			_move(move, false);
+			double score = _search_expectimax(self, model, objective, pass_value, highest + 1.0, 1.0, minimum_reach, pass_budget, cache, positions, approximate);
+			_unmove();
+
+			positions++;
+
+			if (positions > pass_budget)
+				return best_move;
+
+			if (!pass_move || score > pass_value)
+			{
+				pass_value = score;
+				pass_move = move;
+			}
+		}
+
+		best_move = pass_move;
+		value = pass_value;
+
+		if (!approximate)
+			return best_move;
+
+		auto position = std::find(moves.begin(), moves.end(), best_move);
+		std::rotate(moves.begin(), position, position + 1);
+	}
+}
+
+/*
+ * Returns the index of the square next to the given one, or -1 past the edge.
+ * With the board size fixed at compile time, each call from _move reduces to a
+ * comparison and an addition.
+ */
+template <int Rows, int Columns>
+inline int BasicBoard<Rows, Columns>::_get_neighbor(int square, Direction direction)
+{
+	switch (direction)
+	{
+		case NORTH:
+			return square >= Columns ? square - Columns : -1;
+
+		case SOUTH:
+			return square < SQUARES - Columns ? square + Columns : -1;
 
-	return best_move;
+		case WEST:
+			return square % Columns > 0 ? square - 1 : -1;
+
+		case EAST:
+			return square % Columns < Columns - 1 ? square + 1 : -1;
+	}
+
+	return -1;
 }
 
-void Board::_move(const std::shared_ptr<Move> & move, bool output)
+template <int Rows, int Columns>
+void BasicBoard<Rows, Columns>::_move(const std::shared_ptr<Move> & move, bool output)
 {
 	_move_history.push(move);
 	_flip_history.push(move->square);
@@ -183,6 +1002,13 @@ void Board::_move(const std::shared_ptr<Move> & move, bool output)
 
 	move->square->card = move->card;
 	move->square->owner = _current_player;
+	_empty_count--;
+
+	_occupied_squares |= 1u << move->square->index;
+	_red_squares |= _current_player == PLAYER_RED ? 1u << move->square->index : 0;
+
+	_hash -= Zobrist::hand(_current_player, move->card->index);
+	_hash += Zobrist::square(move->square->index, move->card->index, _current_player);
 
 	_execute_basic(move->square, NORTH);
 	_execute_basic(move->square, SOUTH);
@@ -192,7 +1018,8 @@ void Board::_move(const std::shared_ptr<Move> & move, bool output)
 	_change_player();
 }
 
-void Board::_unmove()
+template <int Rows, int Columns>
+void BasicBoard<Rows, Columns>::_unmove()
 {
 	auto move = _move_history.top();
 	_move_history.pop();
@@ -201,27 +1028,56 @@ void Board::_unmove()
 
 	for (auto square = _flip_history.top(); square != move->square; square = _flip_history.top())
 	{
-		square->owner = square->owner == PLAYER_RED ? PLAYER_BLUE : PLAYER_RED;
+		_flip(square);
 		_flip_history.pop();
 	}
 
 	_flip_history.pop();
 
+	_hash -= Zobrist::square(move->square->index, move->card->index, _current_player);
+	_hash += Zobrist::hand(_current_player, move->card->index);
+
 	_unplayed_cards[_current_player][move->card]++;
 	_unplayed_card_counts[_current_player]++;
 	move->square->card = nullptr;
+	_empty_count++;
+
+	_occupied_squares &= ~(1u << move->square->index);
+	_red_squares &= ~(1u << move->square->index);
 }
 
-void Board::_change_player()
+template <int Rows, int Columns>
+void BasicBoard<Rows, Columns>::_change_player()
 {
 	_current_player = _current_player == PLAYER_RED ? PLAYER_BLUE : PLAYER_RED;
+
+	if (_current_player == PLAYER_BLUE)
+		_hash += Zobrist::player();
+	else
+		_hash -= Zobrist::player();
+}
+
+template <int Rows, int Columns>
+void BasicBoard<Rows, Columns>::_flip(const std::shared_ptr<Square> & square)
+{
+	Player owner = square->owner == PLAYER_RED ? PLAYER_BLUE : PLAYER_RED;
+
+	_hash += Zobrist::square(square->index, square->card->index, owner) - Zobrist::square(square->index, square->card->index, square->owner);
+	square->owner = owner;
+	_red_squares ^= 1u << square->index;
 }
 
-void Board::_execute_basic(const std::shared_ptr<Square> & source, Direction direction)
+template <int Rows, int Columns>
+void BasicBoard<Rows, Columns>::_execute_basic(const std::shared_ptr<Square> & source, Direction direction)
 {
-	auto target = source->get_neighbor(direction);
+	int neighbor = _get_neighbor(source->index, direction);
+
+	if (neighbor < 0)
+		return;
 
-	if (!target || !target->card)
+	auto & target = _squares[neighbor];
+
+	if (!target->card)
 		return;
 
 	if (target->owner != source->owner)
@@ -253,13 +1109,14 @@ void Board::_execute_basic(const std::shared_ptr<Square> & source, Direction dir
 
 		if (score > 0)
 		{
-			target->owner = source->owner;
+			_flip(target);
 			_flip_history.push(target);
 		}
 	}
 }
 
-int Board::_get_elemental_adjustment(const std::shared_ptr<Square> & square)
+template <int Rows, int Columns>
+int BasicBoard<Rows, Columns>::_get_elemental_adjustment(const std::shared_ptr<Square> & square)
 {
 	if (_elemental && square->element != ELEMENT_NONE)
 	{
@@ -274,12 +1131,17 @@ int Board::_get_elemental_adjustment(const std::shared_ptr<Square> & square)
 	}
 }
 
-void Board::_initialize_card(const std::shared_ptr<Card> & card)
+template <int Rows, int Columns>
+void BasicBoard<Rows, Columns>::_initialize_card(const std::shared_ptr<Card> & card)
 {
-	_cards.insert(std::make_pair(card->name, card));
+	card->index = _catalog->list.size();
+
+	_catalog->cards.insert(std::make_pair(card->name, card));
+	_catalog->list.push_back(card);
 }
 
-void Board::_initialize_cards()
+template <int Rows, int Columns>
+void BasicBoard<Rows, Columns>::_initialize_cards()
 {
 	_initialize_card(std::make_shared<Card>(1, "Geezard", 1, 1, 5, 4, ELEMENT_NONE));
 	_initialize_card(std::make_shared<Card>(1, "Funguar", 5, 1, 3, 1, ELEMENT_NONE));
@@ -402,23 +1264,350 @@ void Board::_initialize_cards()
 	_initialize_card(std::make_shared<Card>(10, "Squall", 10, 6, 9, 4, ELEMENT_NONE));
 }
 
-void Board::_initialize_moves()
+/*
+ * Creates the moves playing a card, the first time it is dealt to either
+ * player, so that boards only hold moves for the cards in play.
+ */
+template <int Rows, int Columns>
+void BasicBoard<Rows, Columns>::_initialize_moves(const std::shared_ptr<Card> & card)
 {
+	if (_squares[0]->moves.count(card))
+		return;
+
 	for (auto & square : _squares)
+		square->moves.insert(std::make_pair(card, std::make_shared<Move>(square, card)));
+}
+
+template <int Rows, int Columns>
+std::vector<std::shared_ptr<Move>> BasicBoard<Rows, Columns>::_order_moves()
+{
+	auto moves = get_moves();
+
+	int lower, upper, square, card;
+
+	if (get_transposition_table()->probe(_hash, lower, upper, square, card))
+	{
+		auto hash_move = _get_hash_move(square, card);
+		auto position = std::find(moves.begin(), moves.end(), hash_move);
+
+		if (position != moves.end())
+			std::rotate(moves.begin(), position, position + 1);
+	}
+
+	return moves;
+}
+
+template <int Rows, int Columns>
+std::shared_ptr<Move> BasicBoard<Rows, Columns>::_get_hash_move(int square, int card)
+{
+	if (square < 0 || _squares[square]->card)
+		return nullptr;
+
+	auto & unplayed_cards = _unplayed_cards[_current_player];
+	auto pair = unplayed_cards.find(_catalog->list[card]);
+
+	if (pair == unplayed_cards.end() || pair->second == 0)
+		return nullptr;
+
+	return _squares[square]->moves.at(pair->first);
+}
+
+template <int Rows, int Columns>
+int BasicBoard<Rows, Columns>::_search_root(Player self, const std::shared_ptr<Move> & move, int depth, int alpha, int beta, int & positions)
+{
+	_move(move, false);
+	int score = _search_minimax(self, depth, alpha, beta, positions);
+	_unmove();
+
+	positions++;
+
+	return score;
+}
+
+template <int Rows, int Columns>
+bool BasicBoard<Rows, Columns>::_search_child(Player self, const std::shared_ptr<Move> & move, int depth, int & alpha, int & beta, std::shared_ptr<Move> & best_move, int & positions)
+{
+	_move(move, false);
+	int score = _search_minimax(self, depth, alpha, beta, positions);
+	_unmove();
+
+	positions++;
+
+	if (_current_player == self)
+	{
+		if (score > alpha)
+		{
+			alpha = score;
+			best_move = move;
+		}
+	}
+	else
+	{
+		if (score < beta)
+		{
+			beta = score;
+			best_move = move;
+		}
+	}
+
+	return alpha >= beta;
+}
+
+/*
+ * Bounds the final margin for self. A card stays with its owner if it has no
+ * empty square next to it, or if no card left in the other player's hand could
+ * beat it from any of those squares. The cards a player will still hold at the
+ * end stay theirs, and so does the last card placed. Everything else may end
+ * up with either player.
+ *
+ * The cards next to empty squares are only checked against the hands when the
+ * bounds could then fall outside the window (alpha, beta).
+ */
+template <int Rows, int Columns>
+void BasicBoard<Rows, Columns>::_get_margin_bounds(Player self, int alpha, int beta, int & lowest, int & highest)
+{
+	uint32_t occupied = _occupied_squares;
+	uint32_t owned = self == PLAYER_RED ? _red_squares : occupied & ~_red_squares;
+
+	uint32_t empty = ~occupied & ALL_SQUARES;
+	uint32_t exposed = occupied & ((empty >> Columns) | (empty << Columns) | ((empty & ~_column_mask(0)) >> 1) | ((empty & ~_column_mask(Columns - 1)) << 1));
+	uint32_t frozen = occupied & ~exposed;
+
+	Player other = self == PLAYER_RED ? PLAYER_BLUE : PLAYER_RED;
+
+	int kept[2];
+	kept[self] = __builtin_popcount(frozen & owned);
+	kept[other] = __builtin_popcount(frozen & ~owned);
+
+	int moves[2];
+	moves[_current_player] = (_empty_count + 1) / 2;
+	moves[1 - _current_player] = _empty_count / 2;
+
+	int total = SQUARES - _empty_count + _unplayed_card_counts[PLAYER_RED] + _unplayed_card_counts[PLAYER_BLUE];
+
+	for (int player = PLAYER_RED; player <= PLAYER_BLUE; player++)
+		kept[player] += std::max(0, _unplayed_card_counts[player] - moves[player]);
+
+	if (_empty_count > 0 && _unplayed_card_counts[PLAYER_RED] >= moves[PLAYER_RED] && _unplayed_card_counts[PLAYER_BLUE] >= moves[PLAYER_BLUE])
+		kept[_empty_count % 2 == 1 ? _current_player : 1 - _current_player]++;
+
+	lowest = 2 * kept[self] - total;
+	highest = total - 2 * kept[other];
+
+	bool refine_lowest = lowest + 2 * __builtin_popcount(exposed & owned) >= beta;
+	bool refine_highest = highest - 2 * __builtin_popcount(exposed & ~owned) <= alpha;
+
+	if (!refine_lowest && !refine_highest)
+		return;
+
+	/* Cards of self can only be taken by other's cards, and vice versa. */
+	uint32_t checked = (refine_lowest ? exposed & owned : 0) | (refine_highest ? exposed & ~owned : 0);
+
+	int strongest[2][4];
+
+	for (int player = PLAYER_RED; player <= PLAYER_BLUE; player++)
+	{
+		if (!(player == other ? refine_lowest : refine_highest))
+			continue;
+
+		std::fill(strongest[player], strongest[player] + 4, -1);
+
+		for (auto & pair : _unplayed_cards[player])
+		{
+			if (pair.second > 0)
+			{
+				strongest[player][NORTH] = std::max(strongest[player][NORTH], pair.first->top);
+				strongest[player][SOUTH] = std::max(strongest[player][SOUTH], pair.first->bottom);
+				strongest[player][EAST] = std::max(strongest[player][EAST], pair.first->right);
+				strongest[player][WEST] = std::max(strongest[player][WEST], pair.first->left);
+			}
+		}
+	}
+
+	for (int i = 0; i < SQUARES; i++)
 	{
-		for (auto & pair : _cards)
+		if (!(checked & (1u << i)))
+			continue;
+
+		const auto & square = _squares[i];
+		const Card & card = *square->card;
+
+		int attacker = 1 - square->owner;
+		int defense = _get_elemental_adjustment(square);
+		bool vulnerable = false;
+
+		for (int direction = NORTH; direction <= WEST && !vulnerable; direction++)
+		{
+			int neighbor = _get_neighbor(i, static_cast<Direction>(direction));
+
+			if (neighbor < 0 || !(empty & (1u << neighbor)))
+				continue;
+
+			int attack = _elemental && _squares[neighbor]->element != ELEMENT_NONE ? 1 : 0;
+
+			switch (direction)
+			{
+				case NORTH:
+					vulnerable = strongest[attacker][SOUTH] + attack > card.top + defense;
+					break;
+
+				case SOUTH:
+					vulnerable = strongest[attacker][NORTH] + attack > card.bottom + defense;
+					break;
+
+				case EAST:
+					vulnerable = strongest[attacker][WEST] + attack > card.right + defense;
+					break;
+
+				case WEST:
+					vulnerable = strongest[attacker][EAST] + attack > card.left + defense;
+					break;
+			}
+		}
+
+		if (!vulnerable)
 		{
-			square->moves.insert(std::make_pair(pair.second, std::make_shared<Move>(square, pair.second)));
+			if (square->owner == self)
+				lowest += 2;
+			else
+				highest -= 2;
 		}
 	}
 }
 
-int Board::_search_minimax(Player self, int alpha, int beta, int & positions)
+/*
+ * Decides the outcome for self with null-window searches: whether self wins,
+ * with the window (0, 1), and if not, whether self at least draws, with the
+ * window (-1, 0). Bounds already in the transposition table skip whichever
+ * test they answer, so repeated calls on related positions get cheaper.
+ */
+template <int Rows, int Columns>
+Outcome BasicBoard<Rows, Columns>::_solve_outcome(Player self)
+{
+	int depth = _empty_count;
+	int positions = 0;
+
+	int lower = -get_score_bound();
+	int upper = get_score_bound();
+	int square, card;
+
+	if (get_transposition_table()->probe(_hash, lower, upper, square, card) && self != _current_player)
+	{
+		std::swap(lower, upper);
+		lower = -lower;
+		upper = -upper;
+	}
+
+	if (lower > 0 || (upper > 0 && _search_minimax(self, depth, 0, 1, positions) >= 1))
+		return OUTCOME_WIN;
+
+	if (upper < 0 || (lower < 0 && _search_minimax(self, depth, -1, 0, positions) < 0))
+		return OUTCOME_LOSS;
+
+	return OUTCOME_DRAW;
+}
+
+/*
+ * Fail-hard alpha-beta search. Scores are from the perspective of self, while
+ * the transposition table stores bounds from the perspective of the player to
+ * move, so they are negated and swapped when the two differ.
+ */
+template <int Rows, int Columns>
+int BasicBoard<Rows, Columns>::_search_minimax(Player self, int depth, int alpha, int beta, int & positions)
 {
+	if (depth == 0)
+		return _empty_count == 0 ? _evaluate(self) : _evaluator->evaluate(*this, self);
+
+	SearchControl * control = _control.load(std::memory_order_relaxed);
+
+	if (control && control->poll(positions))
+		return alpha;
+
+	int empty = get_empty_count();
+
+	bool maximizing = _current_player == self;
+	bool use_table = depth >= empty && empty >= TRANSPOSITION_MINIMUM_EMPTY;
+
+	int lower, upper, hash_square = -1, hash_card = -1;
+
+	if (use_table && get_transposition_table()->probe(_hash, lower, upper, hash_square, hash_card))
+	{
+		if (!maximizing)
+		{
+			std::swap(lower, upper);
+			lower = -lower;
+			upper = -upper;
+		}
+
+#ifdef TRIPLETRIAD_TRACE
+		if (lower >= beta || upper <= alpha || lower == upper)
+			_trace(depth, alpha, beta, lower >= beta ? beta : (upper <= alpha ? alpha : lower), TRACE_TABLE_HIT | (maximizing ? TRACE_MAXIMIZING : 0), 0, -1, nullptr, 0);
+#endif
+
+		if (lower >= beta)
+			return beta;
+
+		if (upper <= alpha)
+			return alpha;
+
+		if (lower == upper)
+			return lower;
+	}
+
+	int original_alpha = alpha;
+	int original_beta = beta;
+
+	if (depth >= empty)
+	{
+		int lowest, highest;
+		_get_margin_bounds(self, alpha, beta, lowest, highest);
+
+#ifdef TRIPLETRIAD_TRACE
+		if (highest <= alpha || lowest >= beta || lowest == highest)
+			_trace(depth, alpha, beta, highest <= alpha ? alpha : (lowest >= beta ? beta : lowest), TRACE_BOUND | (maximizing ? TRACE_MAXIMIZING : 0), 0, -1, nullptr, 0);
+#endif
+
+		if (highest <= alpha)
+			return alpha;
+
+		if (lowest >= beta)
+			return beta;
+
+		if (lowest == highest)
+			return lowest;
+
+		alpha = std::max(alpha, lowest);
+		beta = std::min(beta, highest);
+	}
+
 	bool valid_move = false;
+	bool cutoff = false;
+
+#ifdef TRIPLETRIAD_TRACE
+	int entry_positions = positions;
+	int searched = 0;
+	int best = -1;
+#endif
+
+	std::shared_ptr<Move> best_move;
+	std::shared_ptr<Move> hash_move = _get_hash_move(hash_square, hash_card);
+
+	if (hash_move)
+	{
+		valid_move = true;
+		cutoff = _search_child(self, hash_move, depth - 1, alpha, beta, best_move, positions);
+
+#ifdef TRIPLETRIAD_TRACE
+		best = best_move ? 0 : -1;
+		searched++;
+#endif
+	}
 
 	for (auto & square : _squares)
 	{
+		if (cutoff)
+			break;
+
 		if (!square->card)
 		{
 			for (auto & pair : _unplayed_cards[_current_player])
@@ -428,28 +1617,27 @@ int Board::_search_minimax(Player self, int alpha, int beta, int & positions)
 					valid_move = true;
 					std::shared_ptr<Move> move(square->moves.at(pair.first));
 
-					_move(move, false);
-					int score = _search_minimax(self, alpha, beta, positions);
-					_unmove();
+					if (move == hash_move)
+						continue;
 
-					if (get_current_player() == self)
-					{
-						if (score >= beta)
-							return beta;
+#ifdef TRIPLETRIAD_TRACE
+					std::shared_ptr<Move> previous_best_move = best_move;
+#endif
 
-						if (score > alpha)
-							alpha = score;
-					}
-					else
-					{
-						if (score <= alpha)
-							return alpha;
+					bool child_cutoff = _search_child(self, move, depth - 1, alpha, beta, best_move, positions);
 
-						if (score < beta)
-							beta = score;
-					}
+#ifdef TRIPLETRIAD_TRACE
+					if (best_move != previous_best_move)
+						best = searched;
+
+					searched++;
+#endif
 
-					positions++;
+					if (child_cutoff)
+					{
+						cutoff = true;
+						break;
+					}
 				}
 			}
 		}
@@ -457,13 +1645,240 @@ int Board::_search_minimax(Player self, int alpha, int beta, int & positions)
 
 	if (!valid_move)
 		return _evaluate(self);
-	else if (get_current_player() == self)
-		return alpha;
+
+	int score = maximizing ? (cutoff ? beta : alpha) : (cutoff ? alpha : beta);
+
+#ifdef TRIPLETRIAD_TRACE
+	_trace(depth, original_alpha, original_beta, score, (maximizing ? TRACE_MAXIMIZING : 0) | (cutoff ? TRACE_CUTOFF : 0) | (hash_move ? TRACE_HASH_MOVE : 0), searched, best, best_move, positions - entry_positions);
+#endif
+
+	if (!use_table || (control && control->is_cancelled()))
+		return score;
+
+	lower = score > original_alpha ? score : -get_score_bound();
+	upper = score < original_beta ? score : get_score_bound();
+
+	if (!maximizing)
+	{
+		std::swap(lower, upper);
+		lower = -lower;
+		upper = -upper;
+	}
+
+	if (best_move)
+		get_transposition_table()->store(_hash, _empty_count, lower, upper, best_move->square->index, best_move->card->index);
+	else
+		get_transposition_table()->store(_hash, _empty_count, lower, upper, -1, -1);
+
+	return score;
+}
+
+#ifdef TRIPLETRIAD_TRACE
+/*
+ * Records the node just searched, if it is sampled. The move counts are those
+ * of the player to move at the node.
+ */
+template <int Rows, int Columns>
+void BasicBoard<Rows, Columns>::_trace(int depth, int alpha, int beta, int score, int flags, int searched, int best, const std::shared_ptr<Move> & best_move, int positions)
+{
+	if (!_tracer || !_tracer->sample(_hash))
+		return;
+
+	int cards = 0;
+
+	for (auto & pair : _unplayed_cards[_current_player])
+		if (pair.second > 0)
+			cards++;
+
+	TraceRecord record;
+
+	record.positions = positions;
+	record.alpha = alpha;
+	record.beta = beta;
+	record.score = score;
+	record.depth = depth;
+	record.empty = _empty_count;
+	record.flags = flags;
+	record.moves = _empty_count * cards;
+	record.searched = searched;
+	record.best = best;
+	record.square = best_move ? best_move->square->index : 255;
+	record.card = best_move ? best_move->card->index : 255;
+
+	_tracer->record(record);
+}
+#endif
+
+/*
+ * Fail-soft expectimax with Star1 pruning: the opponent's moves are searched
+ * from most to least likely, each with the window its value must fall in for
+ * the position's expected value to fall in (alpha, beta), given the bounds on
+ * the values of the moves not yet searched.
+ *
+ * Sets approximate if the value depends on the static evaluator, through the
+ * reach threshold, or if the search stopped for running past budget positions.
+ * Only values that do not are cached, since the others depend on the reach
+ * they were searched with.
+ */
+template <int Rows, int Columns>
+double BasicBoard<Rows, Columns>::_search_expectimax(Player self, const OpponentModel & model, Objective objective, double alpha, double beta, double reach, double minimum_reach, int budget, ExpectimaxCache & cache, int & positions, bool & approximate)
+{
+	if (_empty_count == 0)
+		return _evaluate_objective(self, objective);
+
+	if (reach < minimum_reach)
+	{
+		approximate = true;
+
+		double score = static_cast<double>(_evaluator->evaluate(*this, self)) / Evaluator::SCALE;
+
+		if (objective == OBJECTIVE_OUTCOME)
+			return score > 0.0 ? 1.0 : (score < 0.0 ? -1.0 : 0.0);
+		else
+			return score;
+	}
+
+	bool use_cache = _empty_count >= TRANSPOSITION_MINIMUM_EMPTY;
+	auto cached = use_cache ? cache.find(_hash) : cache.end();
+
+	if (cached != cache.end())
+	{
+		if (cached->second.lower >= beta || cached->second.lower == cached->second.upper)
+			return cached->second.lower;
+
+		if (cached->second.upper <= alpha)
+			return cached->second.upper;
+	}
+
+	double highest = objective == OBJECTIVE_OUTCOME ? 1.0 : get_score_bound() - 1;
+	double lowest = -highest;
+
+	auto moves = get_moves();
+	double value = lowest;
+
+	bool subtree_approximate = false;
+
+	if (_current_player == self)
+	{
+		for (auto & move : moves)
+		{
+			_move(move, false);
+			value = std::max(value, _search_expectimax(self, model, objective, std::max(alpha, value), beta, reach, minimum_reach, budget, cache, positions, subtree_approximate));
+			_unmove();
+
+			positions++;
+
+			if (value >= beta || positions > budget)
+				break;
+		}
+	}
+	else
+	{
+		std::vector<double> probabilities;
+		std::vector<size_t> order(moves.size());
+
+		std::vector<int> flips;
+
+		for (auto & move : moves)
+			flips.push_back(count_flips(move));
+
+		positions += moves.size();
+		model.get_probabilities(flips, probabilities);
+
+		for (size_t i = 0; i < order.size(); i++)
+			order[i] = i;
+
+		std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+			return probabilities[a] > probabilities[b];
+		});
+
+		double sum = 0.0;
+		double remaining = 1.0;
+
+		for (auto i : order)
+		{
+			double probability = probabilities[i];
+
+			if (probability == 0.0)
+				break;
+
+			double child_alpha = (alpha - sum - (remaining - probability) * highest) / probability;
+			double child_beta = (beta - sum - (remaining - probability) * lowest) / probability;
+
+			_move(moves[i], false);
+			double score = _search_expectimax(self, model, objective, child_alpha, child_beta, reach * probability, minimum_reach, budget, cache, positions, subtree_approximate);
+			_unmove();
+
+			positions++;
+
+			if (positions > budget)
+			{
+				subtree_approximate = true;
+				break;
+			}
+
+			if (score <= child_alpha)
+			{
+				sum += probability * score + (remaining - probability) * highest;
+				remaining = 0.0;
+				break;
+			}
+
+			if (score >= child_beta)
+			{
+				sum += probability * score + (remaining - probability) * lowest;
+				remaining = 0.0;
+				break;
+			}
+
+			sum += probability * score;
+			remaining -= probability;
+		}
+
+		value = sum;
+	}
+
+	if (positions > budget)
+		subtree_approximate = true;
+
+	approximate = approximate || subtree_approximate;
+
+	if (!use_cache || subtree_approximate)
+		return value;
+
+	ExpectimaxBounds bounds = {lowest, highest};
+
+	if (cached != cache.end())
+		bounds = cached->second;
+
+	if (value > alpha)
+		bounds.lower = std::max(bounds.lower, value);
+
+	if (value < beta)
+		bounds.upper = std::min(bounds.upper, value);
+
+	cache[_hash] = bounds;
+
+	return value;
+}
+
+template <int Rows, int Columns>
+double BasicBoard<Rows, Columns>::_evaluate_objective(Player self, Objective objective)
+{
+	int score = _evaluate(self);
+
+	if (objective == OBJECTIVE_OUTCOME)
+		return score > 0 ? 1.0 : (score < 0 ? -1.0 : 0.0);
 	else
-		return beta;
+		return score;
 }
 
-int Board::_evaluate(Player player)
+template <int Rows, int Columns>
+int BasicBoard<Rows, Columns>::_evaluate(Player player)
 {
 	return get_score(player) - get_score(player == PLAYER_RED ? PLAYER_BLUE : PLAYER_RED);
 }
+
+template class BasicBoard<3, 3>;
+template class BasicBoard<4, 4>;
+template class BasicBoard<5, 5>;
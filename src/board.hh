@@ -23,63 +23,228 @@
 #ifndef TRIPLETRIAD_BOARD_HH
 #define TRIPLETRIAD_BOARD_HH
 
+#include <atomic>
+#include <cstdint>
+#include <future>
 #include <memory>
 #include <stack>
+#include <unordered_map>
 #include <vector>
 
 #include "common.hh"
+#include "evaluator.hh"
 #include "move.hh"
+#include "opponent.hh"
+#include "position.hh"
+#include "search.hh"
 #include "square.hh"
+#include "trace.hh"
+#include "transposition.hh"
 
-class Board
+struct ExpectimaxBounds
 {
+	double lower;
+	double upper;
+};
+
+typedef std::unordered_map<uint64_t, ExpectimaxBounds> ExpectimaxCache;
+
+struct MoveAnalysis
+{
+	std::shared_ptr<Move> move;
+
+	int score;
+	Bound bound;
+};
+
+struct MoveOutcome
+{
+	std::shared_ptr<Move> move;
+	Outcome outcome;
+};
+
+/*
+ * The cards that can be dealt, by name and by index. Copies of a board share
+ * its catalog.
+ */
+struct CardCatalog
+{
+	std::unordered_map<std::string, std::shared_ptr<Card>> cards;
+	std::vector<std::shared_ptr<Card>> list;
+};
+
+/*
+ * The game state and search. The board size is a template parameter so that
+ * the standard 3x3 game compiles with constant bounds throughout; each player
+ * holds one card more than half the number of squares.
+ */
+template <int Rows, int Columns>
+class BasicBoard
+{
+	friend class Evaluator;
+
 	public:
-		Board(Player first_player, bool elemental);
+		BasicBoard(Player first_player, bool elemental);
+		BasicBoard(const BasicBoard & other);
+
+		BasicBoard & operator=(const BasicBoard & other);
+
+		static const int SQUARES = Rows * Columns;
+		static const int HAND_SIZE = SQUARES / 2 + 1;
+		static const uint32_t ALL_SQUARES = (1u << SQUARES) - 1;
+
+		/*
+		 * The state of a game by square and card index, independent of the
+		 * board's own objects, so that it can be restored on the board that
+		 * took it or on any copy of that board. Each hand holds up to
+		 * HAND_SIZE distinct cards, each with its count, so that taking and
+		 * restoring a snapshot does not allocate.
+		 */
+		struct Snapshot
+		{
+			Player current_player;
+			bool elemental;
+
+			int cards[SQUARES];
+			Player owners[SQUARES];
+			Element elements[SQUARES];
+
+			int hand_cards[2][HAND_SIZE];
+			int hand_counts[2][HAND_SIZE];
+			int hand_sizes[2];
+			int unplayed_card_counts[2];
+
+			uint64_t hash;
+		};
+
+		Snapshot snapshot() const;
+		void restore(const Snapshot & snapshot);
+		std::shared_ptr<BasicBoard> fork() const;
+
+		void reset(Player first_player, bool elemental);
 
 		bool activate_card(Player player, const std::string & name);
+		void activate_card(Player player, const std::shared_ptr<Card> & card);
 		void activate_card_level(Player player, int level);
 
 		void set_element(int row, int column, Element element);
+		void set_transposition_table(const std::shared_ptr<TranspositionTable> & table);
+		bool set_tracer(const std::shared_ptr<SearchTracer> & tracer);
+
+		const std::shared_ptr<TranspositionTable> & get_transposition_table();
+
+		const std::vector<std::shared_ptr<Card>> & get_cards() const;
 
 		bool move(const std::shared_ptr<Move> & move, bool output);
 
+		int get_rows() const;
+		int get_columns() const;
+
 		Player get_current_player() const;
 		int get_score(Player player) const;
+		int get_score_bound() const;
+		int get_empty_count() const;
 
 		bool is_complete() const;
 
+		bool encode(Position & position) const;
+		bool decode(const Position & position);
+
 		std::shared_ptr<Move> get_move(int row, int column, const std::string & name);
 
+		std::vector<std::shared_ptr<Move>> get_moves();
+		int count_flips(const std::shared_ptr<Move> & move);
+		void perft(int depth, long & leaves, long & flips);
+
 		std::shared_ptr<Move> suggest_move();
+		std::shared_ptr<Move> suggest_move(int depth);
+		std::shared_ptr<Move> find_move(int depth, int & best_score, int & positions);
+		std::future<std::shared_ptr<Move>> find_move_async(int depth, const std::shared_ptr<SearchControl> & control);
+		std::vector<MoveAnalysis> analyze_moves(bool exact);
+		Outcome solve_outcome();
+		std::vector<MoveOutcome> analyze_outcomes();
+		int search(Player self, int alpha, int beta, int & positions);
+
+		std::shared_ptr<Move> find_move_expectimax(const OpponentModel & model, Objective objective, ExpectimaxCache & cache, int budget, double & value, int & positions);
 
 	private:
 		void _move(const std::shared_ptr<Move> & move, bool output);
 		void _unmove();
 
 		void _change_player();
+		void _flip(const std::shared_ptr<Square> & square);
+		static int _get_neighbor(int square, Direction direction);
+		static constexpr uint32_t _column_mask(int column, int row = 0);
 		void _execute_basic(const std::shared_ptr<Square> & source, Direction direction);
 
 		int _get_elemental_adjustment(const std::shared_ptr<Square> & square);
 
 		void _initialize_card(const std::shared_ptr<Card> & card);
 		void _initialize_cards();
-		void _initialize_moves();
-
-		int _search_minimax(Player self, int alpha, int beta, int & positions);
+		void _initialize_moves(const std::shared_ptr<Card> & card);
+
+		std::vector<std::shared_ptr<Move>> _order_moves();
+		std::shared_ptr<Move> _get_hash_move(int square, int card);
+
+		int _search_root(Player self, const std::shared_ptr<Move> & move, int depth, int alpha, int beta, int & positions);
+		bool _search_child(Player self, const std::shared_ptr<Move> & move, int depth, int & alpha, int & beta, std::shared_ptr<Move> & best_move, int & positions);
+		int _search_minimax(Player self, int depth, int alpha, int beta, int & positions);
+		Outcome _solve_outcome(Player self);
+		void _get_margin_bounds(Player self, int alpha, int beta, int & lowest, int & highest);
+#ifdef TRIPLETRIAD_TRACE
+		void _trace(int depth, int alpha, int beta, int score, int flags, int searched, int best, const std::shared_ptr<Move> & best_move, int positions);
+#endif
 		int _evaluate(Player player);
 
+		double _search_expectimax(Player self, const OpponentModel & model, Objective objective, double alpha, double beta, double reach, double minimum_reach, int budget, ExpectimaxCache & cache, int & positions, bool & approximate);
+		double _evaluate_objective(Player self, Objective objective);
+
 		Player _current_player;
 
 		bool _elemental;
 
-		std::unordered_map<std::string, std::shared_ptr<Card>> _cards;
+		std::shared_ptr<CardCatalog> _catalog;
 		std::vector<std::unordered_map<std::shared_ptr<Card>, int>> _unplayed_cards;
 		std::vector<int> _unplayed_card_counts;
 
 		std::vector<std::shared_ptr<Square>> _squares;
+		int _empty_count;
+
+		uint32_t _occupied_squares;
+		uint32_t _red_squares;
 
 		std::stack<std::shared_ptr<Move>> _move_history;
 		std::stack<std::shared_ptr<Square>> _flip_history;
+
+		uint64_t _hash;
+		std::shared_ptr<TranspositionTable> _transposition_table;
+		std::shared_ptr<Evaluator> _evaluator;
+
+		std::atomic<SearchControl *> _control;
+
+#ifdef TRIPLETRIAD_TRACE
+		std::shared_ptr<SearchTracer> _tracer;
+#endif
 };
 
+template <int Rows, int Columns>
+const int BasicBoard<Rows, Columns>::SQUARES;
+
+template <int Rows, int Columns>
+const int BasicBoard<Rows, Columns>::HAND_SIZE;
+
+template <int Rows, int Columns>
+const uint32_t BasicBoard<Rows, Columns>::ALL_SQUARES;
+
+/*
+ * Returns the set of squares in a column, one bit per square index.
+ */
+template <int Rows, int Columns>
+constexpr uint32_t BasicBoard<Rows, Columns>::_column_mask(int column, int row)
+{
+	return row >= Rows ? 0 : (1u << (row * Columns + column)) | _column_mask(column, row + 1);
+}
+
+typedef BasicBoard<3, 3> Board;
+
 #endif
@@ -29,5 +29,6 @@ Card::Card(int level, const std::string & name, int top, int bottom, int left, i
 	bottom(bottom),
 	left(left),
 	right(right),
-	element(element)
+	element(element),
+	index(-1)
 { }
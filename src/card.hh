@@ -42,6 +42,8 @@ class Card
 		const int right;
 
 		const Element element;
+
+		int index;
 };
 
 #endif
@@ -23,6 +23,13 @@
 #ifndef TRIPLETRIAD_COMMON_HH
 #define TRIPLETRIAD_COMMON_HH
 
+enum Bound
+{
+	BOUND_EXACT,
+	BOUND_LOWER,
+	BOUND_UPPER
+};
+
 enum Direction
 {
 	NORTH,
@@ -44,6 +51,19 @@ enum Element
 	ELEMENT_HOLY
 };
 
+enum Objective
+{
+	OBJECTIVE_MARGIN,
+	OBJECTIVE_OUTCOME
+};
+
+enum Outcome
+{
+	OUTCOME_LOSS,
+	OUTCOME_DRAW,
+	OUTCOME_WIN
+};
+
 enum Player
 {
 	PLAYER_RED,
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdexcept>
+
+#include "dealer.hh"
+
+/*
+ * Throws std::invalid_argument if no card is within the range of levels.
+ */
+template <int Rows, int Columns>
+BasicDealer<Rows, Columns>::BasicDealer(const BasicBoard<Rows, Columns> & board, int minimum_level, int maximum_level, bool elemental) :
+	_elemental(elemental)
+{
+	for (auto & card : board.get_cards())
+	{
+		if (card->level >= minimum_level && card->level <= maximum_level)
+			_pool.push_back(card);
+	}
+
+	if (_pool.empty())
+		throw std::invalid_argument("no cards within the range of levels");
+}
+
+/*
+ * Resets the board with a random first player and deals new hands, which are
+ * also returned in hands.
+ */
+template <int Rows, int Columns>
+void BasicDealer<Rows, Columns>::deal(BasicBoard<Rows, Columns> & board, std::mt19937 & random, std::vector<std::shared_ptr<Card>> hands[2]) const
+{
+	board.reset(random() & 1 ? PLAYER_BLUE : PLAYER_RED, _elemental);
+
+	for (int player = PLAYER_RED; player <= PLAYER_BLUE; player++)
+	{
+		deal_hand(random, hands[player]);
+
+		for (auto & card : hands[player])
+			board.activate_card(static_cast<Player>(player), card);
+	}
+
+	if (_elemental)
+	{
+		std::vector<Element> elements;
+		deal_elements(random, elements);
+
+		for (int row = 0; row < board.get_rows(); row++)
+		{
+			for (int column = 0; column < board.get_columns(); column++)
+			{
+				if (elements[row * board.get_columns() + column] != ELEMENT_NONE)
+					board.set_element(row, column, elements[row * board.get_columns() + column]);
+			}
+		}
+	}
+}
+
+template <int Rows, int Columns>
+void BasicDealer<Rows, Columns>::deal_hand(std::mt19937 & random, std::vector<std::shared_ptr<Card>> & hand) const
+{
+	std::uniform_int_distribution<size_t> card_distribution(0, _pool.size() - 1);
+
+	hand.clear();
+
+	for (int i = 0; i < BasicBoard<Rows, Columns>::HAND_SIZE; i++)
+		hand.push_back(_pool[card_distribution(random)]);
+}
+
+/*
+ * Deals an element for each square in row-major order, ELEMENT_NONE for about
+ * two thirds of them.
+ */
+template <int Rows, int Columns>
+void BasicDealer<Rows, Columns>::deal_elements(std::mt19937 & random, std::vector<Element> & elements) const
+{
+	std::uniform_int_distribution<int> element_distribution(ELEMENT_NONE, 3 * ELEMENT_HOLY);
+
+	elements.clear();
+
+	for (int square = 0; square < BasicBoard<Rows, Columns>::SQUARES; square++)
+	{
+		int element = element_distribution(random);
+		elements.push_back(element <= ELEMENT_HOLY ? static_cast<Element>(element) : ELEMENT_NONE);
+	}
+}
+
+template class BasicDealer<3, 3>;
+template class BasicDealer<4, 4>;
+template class BasicDealer<5, 5>;
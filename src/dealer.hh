@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_DEALER_HH
+#define TRIPLETRIAD_DEALER_HH
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "board.hh"
+#include "card.hh"
+
+/*
+ * Sets up random games: a full hand per player drawn with replacement from the
+ * cards within a range of levels, and in elemental games a random element on
+ * roughly a third of the squares.
+ */
+template <int Rows, int Columns>
+class BasicDealer
+{
+	public:
+		BasicDealer(const BasicBoard<Rows, Columns> & board, int minimum_level, int maximum_level, bool elemental);
+
+		void deal(BasicBoard<Rows, Columns> & board, std::mt19937 & random, std::vector<std::shared_ptr<Card>> hands[2]) const;
+		void deal_hand(std::mt19937 & random, std::vector<std::shared_ptr<Card>> & hand) const;
+		void deal_elements(std::mt19937 & random, std::vector<Element> & elements) const;
+
+	private:
+		std::vector<std::shared_ptr<Card>> _pool;
+
+		bool _elemental;
+};
+
+typedef BasicDealer<3, 3> Dealer;
+
+#endif
@@ -0,0 +1,562 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+#include <unistd.h>
+
+#include "deck.hh"
+#include "dealer.hh"
+#include "evaluator.hh"
+#include "options.hh"
+
+static const int VERSION = 1;
+
+/* Matchup keys hold the hand in the low bits and the matchup number above. */
+static const int KEY_CARD_BITS = 7;
+static const int KEY_HAND_BITS = 5 * KEY_CARD_BITS;
+
+DeckBuilder::DeckBuilder(const std::vector<std::shared_ptr<Card>> & collection, int minimum_level, int maximum_level, int opponents, int depth, bool elemental, unsigned int seed) :
+	_score(0.0),
+	_started(false),
+	_minimum_level(minimum_level),
+	_maximum_level(maximum_level),
+	_depth(depth),
+	_elemental(elemental),
+	_seed(seed),
+	_file(nullptr),
+	_next_hand(0),
+	_best_score(0.0),
+	_hands(0),
+	_matchups(0),
+	_memoized_matchups(0)
+{
+	Board board(PLAYER_RED, elemental);
+	Dealer dealer(board, minimum_level, maximum_level, elemental);
+
+	_cards = board.get_cards();
+	_available.resize(_cards.size());
+
+	for (auto & card : collection)
+		_available[card->index]++;
+
+	std::mt19937 random(seed);
+	std::vector<std::shared_ptr<Card>> hand;
+
+	_opponents.resize(opponents);
+
+	for (auto & opponent : _opponents)
+	{
+		dealer.deal_hand(random, hand);
+
+		for (auto & card : hand)
+			opponent.hand.push_back(card->index);
+
+		if (elemental)
+			dealer.deal_elements(random, opponent.elements);
+		else
+			opponent.elements.assign(board.get_rows() * board.get_columns(), ELEMENT_NONE);
+	}
+}
+
+DeckBuilder::~DeckBuilder()
+{
+	if (_file)
+		std::fclose(_file);
+}
+
+/*
+ * Loads the matchups memoized in a checkpoint file and appends new ones to it,
+ * creating the file if needed. Fails if the file was written with different
+ * settings. A partially written last line is discarded.
+ */
+bool DeckBuilder::open_checkpoint(const std::string & path)
+{
+	std::string header = _get_header();
+
+	_file = std::fopen(path.c_str(), "r+");
+
+	if (!_file)
+	{
+		_file = std::fopen(path.c_str(), "w+");
+
+		return _file && std::fputs(header.c_str(), _file) >= 0 && std::fflush(_file) == 0;
+	}
+
+	char line[256];
+
+	if (!std::fgets(line, sizeof(line), _file) || header != line)
+	{
+		std::fclose(_file);
+		_file = nullptr;
+
+		return false;
+	}
+
+	long size = std::ftell(_file);
+
+	while (std::fgets(line, sizeof(line), _file) && std::strchr(line, '\n'))
+	{
+		unsigned long long key;
+		int score;
+
+		if (std::sscanf(line, "%llx %d", &key, &score) != 2)
+			break;
+
+		_memo[key] = score;
+		size = std::ftell(_file);
+	}
+
+	std::fflush(_file);
+
+	if (ftruncate(fileno(_file), size) != 0 || std::fseek(_file, size, SEEK_SET) != 0)
+		return false;
+
+	return true;
+}
+
+/*
+ * Makes every thread's board use the given table instead of its own.
+ */
+void DeckBuilder::set_transposition_table(const std::shared_ptr<TranspositionTable> & table)
+{
+	_transposition_table = table;
+}
+
+/*
+ * Takes one step of the search: the first call evaluates the starting hand,
+ * and each later one moves to the best hand differing by a single card if it
+ * is an improvement. Returns false once no step is possible.
+ */
+bool DeckBuilder::step(int threads)
+{
+	while (static_cast<int>(_boards.size()) < threads)
+	{
+		_boards.push_back(std::make_shared<Board>(PLAYER_RED, _elemental));
+
+		if (_transposition_table)
+			_boards.back()->set_transposition_table(_transposition_table);
+	}
+
+	if (!_started)
+	{
+		std::vector<int> order;
+
+		for (size_t card = 0; card < _cards.size(); card++)
+		{
+			for (int copy = 0; copy < _available[card]; copy++)
+				order.push_back(card);
+		}
+
+		if (order.size() < 5)
+			return false;
+
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+			return _cards[a]->top + _cards[a]->bottom + _cards[a]->left + _cards[a]->right > _cards[b]->top + _cards[b]->bottom + _cards[b]->left + _cards[b]->right;
+		});
+
+		_hand.assign(order.begin(), order.begin() + 5);
+		std::sort(_hand.begin(), _hand.end());
+
+		_best_score = -std::numeric_limits<double>::infinity();
+		_score = _evaluate(*_boards[0], _hand);
+		_visited.insert(_get_key(_hand));
+		_started = true;
+
+		return true;
+	}
+
+	std::vector<std::vector<int>> hands;
+
+	for (size_t slot = 0; slot < _hand.size(); slot++)
+	{
+		if (slot > 0 && _hand[slot] == _hand[slot - 1])
+			continue;
+
+		for (size_t card = 0; card < _cards.size(); card++)
+		{
+			if (static_cast<int>(card) == _hand[slot] || _available[card] <= std::count(_hand.begin(), _hand.end(), card))
+				continue;
+
+			std::vector<int> hand(_hand);
+			hand[slot] = card;
+			std::sort(hand.begin(), hand.end());
+
+			if (_is_dominated(hand) || !_visited.insert(_get_key(hand)).second)
+				continue;
+
+			hands.push_back(hand);
+		}
+	}
+
+	std::vector<double> scores(hands.size());
+	std::vector<std::thread> workers;
+
+	_next_hand = 0;
+	_best_score = _score;
+
+	if (_transposition_table)
+		_transposition_table->next_generation();
+
+	for (int thread = 0; thread < threads && !_transposition_table; thread++)
+		_boards[thread]->get_transposition_table()->next_generation();
+
+	for (int thread = 0; thread < threads; thread++)
+		workers.push_back(std::thread(&DeckBuilder::_run_thread, this, std::ref(*_boards[thread]), std::cref(hands), std::ref(scores)));
+
+	for (auto & worker : workers)
+		worker.join();
+
+	int best = -1;
+
+	for (size_t i = 0; i < hands.size(); i++)
+	{
+		if (scores[i] > (best < 0 ? _score : scores[best]))
+			best = i;
+	}
+
+	if (best < 0)
+		return false;
+
+	_hand = hands[best];
+	_score = scores[best];
+
+	return true;
+}
+
+std::vector<std::shared_ptr<Card>> DeckBuilder::get_hand() const
+{
+	std::vector<std::shared_ptr<Card>> hand;
+
+	for (auto card : _hand)
+		hand.push_back(_cards[card]);
+
+	return hand;
+}
+
+double DeckBuilder::get_score() const
+{
+	return _score;
+}
+
+long DeckBuilder::get_hands() const
+{
+	return _hands;
+}
+
+long DeckBuilder::get_matchups() const
+{
+	return _matchups;
+}
+
+long DeckBuilder::get_memoized_matchups() const
+{
+	return _memoized_matchups;
+}
+
+void DeckBuilder::_run_thread(Board & board, const std::vector<std::vector<int>> & hands, std::vector<double> & scores)
+{
+	while (true)
+	{
+		size_t hand;
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			hand = _next_hand++;
+		}
+
+		if (hand >= hands.size())
+			break;
+
+		double score = _evaluate(board, hands[hand]);
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		scores[hand] = score;
+		_best_score = std::max(_best_score, score);
+	}
+}
+
+/*
+ * Returns the hand's mean margin over all matchups, or negative infinity as
+ * soon as it is certain to be lower than the best score found so far.
+ */
+double DeckBuilder::_evaluate(Board & board, const std::vector<int> & hand)
+{
+	int matchups = 2 * _opponents.size();
+	double maximum = (board.get_score_bound() - 1) * Evaluator::SCALE;
+	double total = 0.0;
+
+	uint64_t key = _get_key(hand);
+
+	for (int matchup = 0; matchup < matchups; matchup++)
+	{
+		uint64_t matchup_key = key | static_cast<uint64_t>(matchup) << KEY_HAND_BITS;
+		int score;
+
+		std::unique_lock<std::mutex> lock(_mutex);
+
+		auto memoized = _memo.find(matchup_key);
+
+		if (memoized != _memo.end())
+		{
+			score = memoized->second;
+			_memoized_matchups++;
+		}
+		else
+		{
+			lock.unlock();
+			score = _play(board, hand, matchup);
+			lock.lock();
+
+			_memo[matchup_key] = score;
+			_matchups++;
+
+			if (_file)
+			{
+				std::fprintf(_file, "%llx %d\n", static_cast<unsigned long long>(matchup_key), score);
+				std::fflush(_file);
+			}
+		}
+
+		total += score;
+
+		if ((total + (matchups - matchup - 1) * maximum) / (matchups * Evaluator::SCALE) < _best_score)
+			return -std::numeric_limits<double>::infinity();
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_hands++;
+
+	return total / (matchups * Evaluator::SCALE);
+}
+
+/*
+ * Plays one matchup against an opponent, who moves first in odd-numbered
+ * matchups, and returns the hand's margin in units of 1/SCALE of a card.
+ */
+int DeckBuilder::_play(Board & board, const std::vector<int> & hand, int matchup)
+{
+	const Opponent & opponent = _opponents[matchup / 2];
+	Player first_player = matchup % 2 ? PLAYER_BLUE : PLAYER_RED;
+
+	board.reset(first_player, _elemental);
+
+	for (auto card : hand)
+		board.activate_card(PLAYER_RED, board.get_cards()[card]);
+
+	for (auto card : opponent.hand)
+		board.activate_card(PLAYER_BLUE, board.get_cards()[card]);
+
+	for (int row = 0; row < board.get_rows(); row++)
+	{
+		for (int column = 0; column < board.get_columns(); column++)
+		{
+			if (opponent.elements[row * board.get_columns() + column] != ELEMENT_NONE)
+				board.set_element(row, column, opponent.elements[row * board.get_columns() + column]);
+		}
+	}
+
+	int score;
+	int positions = 0;
+
+	bool exact = _depth >= board.get_empty_count();
+
+	board.find_move(_depth, score, positions);
+
+	if (exact)
+		score *= Evaluator::SCALE;
+
+	return first_player == PLAYER_RED ? score : -score;
+}
+
+bool DeckBuilder::_dominates(const std::shared_ptr<Card> & card, const std::shared_ptr<Card> & other) const
+{
+	if (card == other || (_elemental && card->element != other->element))
+		return false;
+
+	if (card->top < other->top || card->bottom < other->bottom || card->left < other->left || card->right < other->right)
+		return false;
+
+	return card->top > other->top || card->bottom > other->bottom || card->left > other->left || card->right > other->right || card->index < other->index;
+}
+
+/*
+ * Checks whether the hand holds a card that could be swapped for a dominating
+ * card left in the collection. Cards with identical stats dominate each other
+ * by index, so only one of a set of equivalent hands is searched.
+ */
+bool DeckBuilder::_is_dominated(const std::vector<int> & hand) const
+{
+	for (auto card : hand)
+	{
+		for (size_t other = 0; other < _cards.size(); other++)
+		{
+			if (_available[other] > std::count(hand.begin(), hand.end(), other) && _dominates(_cards[other], _cards[card]))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+uint64_t DeckBuilder::_get_key(const std::vector<int> & hand) const
+{
+	uint64_t key = 0;
+
+	for (size_t i = 0; i < hand.size(); i++)
+		key |= static_cast<uint64_t>(hand[i]) << (i * KEY_CARD_BITS);
+
+	return key;
+}
+
+std::string DeckBuilder::_get_header() const
+{
+	char header[128];
+
+	std::snprintf(header, sizeof(header), "TTDECK %d levels %d-%d opponents %d depth %d elemental %d seed %u\n", VERSION, _minimum_level, _maximum_level, static_cast<int>(_opponents.size()), _depth, _elemental ? 1 : 0, _seed);
+
+	return header;
+}
+
+int deck_main(const std::vector<std::string> & arguments)
+{
+	if (arguments.size() < 2)
+	{
+		std::cout << "ERROR:    No collection file given" << std::endl;
+		return 1;
+	}
+
+	int opponents = 20;
+	int depth = 9;
+	bool elemental = false;
+	unsigned int seed = 1;
+
+	std::string checkpoint;
+	BatchOptions options;
+
+	for (size_t i = 2; i < arguments.size(); i++)
+	{
+		if (options.parse(arguments, i))
+			continue;
+
+		if (arguments[i] == "elemental")
+			elemental = true;
+		else if (i + 1 >= arguments.size())
+			break;
+		else if (arguments[i] == "opponents")
+			opponents = std::max(1, std::atoi(arguments[++i].c_str()));
+		else if (arguments[i] == "depth")
+			depth = std::max(1, std::atoi(arguments[++i].c_str()));
+		else if (arguments[i] == "checkpoint")
+			checkpoint = arguments[++i];
+		else if (arguments[i] == "seed")
+			seed = std::atoi(arguments[++i].c_str());
+	}
+
+	if (!options.check())
+		return 1;
+
+	Board board(PLAYER_RED, elemental);
+
+	std::ifstream input(arguments[1]);
+	std::vector<std::shared_ptr<Card>> collection;
+	std::string line;
+
+	if (!input)
+	{
+		std::cout << "ERROR:    Cannot open " << arguments[1] << std::endl;
+		return 1;
+	}
+
+	while (std::getline(input, line))
+	{
+		line.erase(line.find_last_not_of(" \t\r") + 1);
+		line.erase(0, line.find_first_not_of(" \t"));
+
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		auto card = std::find_if(board.get_cards().begin(), board.get_cards().end(), [&](const std::shared_ptr<Card> & card) {
+			return card->name == line;
+		});
+
+		if (card == board.get_cards().end())
+		{
+			std::cout << "ERROR:    Unknown card: " << line << std::endl;
+			return 1;
+		}
+
+		collection.push_back(*card);
+	}
+
+	std::shared_ptr<TranspositionTable> table;
+
+	if (!options.create_table(table))
+		return 1;
+
+	DeckBuilder builder(collection, options.minimum_level, options.maximum_level, opponents, depth, elemental, seed);
+
+	if (table)
+		builder.set_transposition_table(table);
+
+	if (!checkpoint.empty() && !builder.open_checkpoint(checkpoint))
+	{
+		std::cout << "ERROR:    Cannot open " << checkpoint << " or its header does not match" << std::endl;
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (int step = 0; builder.step(options.threads); step++)
+	{
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << std::left << std::fixed << "DECK:     ";
+		std::cout << std::setw(6) << "Step:" << std::setw(6) << step;
+		std::cout << std::setw(7) << "Score:" << std::setw(9) << std::setprecision(3) << builder.get_score();
+		std::cout << std::setw(7) << "Hands:" << std::setw(8) << builder.get_hands();
+		std::cout << std::setw(10) << "Matchups:" << std::setw(10) << builder.get_matchups();
+		std::cout << std::setw(10) << "Memoized:" << std::setw(10) << builder.get_memoized_matchups();
+		std::cout << std::setw(9) << "Seconds:" << std::setw(8) << std::setprecision(0) << seconds;
+		std::cout << std::endl;
+
+		std::cout << "HAND:     ";
+
+		auto hand = builder.get_hand();
+
+		for (size_t i = 0; i < hand.size(); i++)
+			std::cout << (i > 0 ? ", " : "") << hand[i]->name;
+
+		std::cout << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_DECK_HH
+#define TRIPLETRIAD_DECK_HH
+
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "board.hh"
+#include "card.hh"
+
+/*
+ * Searches a card collection for the hand with the best expected margin
+ * against a fixed sample of random opponents, each played once with either
+ * player moving first.
+ *
+ * Starting from the strongest cards, the search repeatedly swaps one card for
+ * the best improvement until none is found. Hands holding a card that another
+ * card in the collection dominates (no weaker side and the same element) are
+ * skipped, as the swap can never hurt under the basic rules, and a hand stops
+ * being evaluated once it can no longer beat the best one found.
+ *
+ * Matchup results are memoized and can be kept in a checkpoint file, a header
+ * line followed by one "key score" line per matchup, so that an interrupted
+ * run can be resumed and repeats no searches.
+ */
+class DeckBuilder
+{
+	public:
+		DeckBuilder(const std::vector<std::shared_ptr<Card>> & collection, int minimum_level, int maximum_level, int opponents, int depth, bool elemental, unsigned int seed);
+		~DeckBuilder();
+
+		bool open_checkpoint(const std::string & path);
+
+		void set_transposition_table(const std::shared_ptr<TranspositionTable> & table);
+
+		bool step(int threads);
+
+		std::vector<std::shared_ptr<Card>> get_hand() const;
+		double get_score() const;
+
+		long get_hands() const;
+		long get_matchups() const;
+		long get_memoized_matchups() const;
+
+	private:
+		struct Opponent
+		{
+			std::vector<int> hand;
+			std::vector<Element> elements;
+		};
+
+		void _run_thread(Board & board, const std::vector<std::vector<int>> & hands, std::vector<double> & scores);
+
+		double _evaluate(Board & board, const std::vector<int> & hand);
+		int _play(Board & board, const std::vector<int> & hand, int matchup);
+
+		bool _dominates(const std::shared_ptr<Card> & card, const std::shared_ptr<Card> & other) const;
+		bool _is_dominated(const std::vector<int> & hand) const;
+
+		uint64_t _get_key(const std::vector<int> & hand) const;
+		std::string _get_header() const;
+
+		std::vector<std::shared_ptr<Card>> _cards;
+		std::vector<int> _available;
+
+		std::vector<std::shared_ptr<Board>> _boards;
+		std::shared_ptr<TranspositionTable> _transposition_table;
+
+		std::vector<int> _hand;
+		double _score;
+		bool _started;
+
+		std::vector<Opponent> _opponents;
+
+		int _minimum_level;
+		int _maximum_level;
+		int _depth;
+		bool _elemental;
+		unsigned int _seed;
+
+		std::unordered_map<uint64_t, int> _memo;
+		std::unordered_set<uint64_t> _visited;
+
+		std::FILE * _file;
+
+		std::mutex _mutex;
+		size_t _next_hand;
+		double _best_score;
+
+		long _hands;
+		long _matchups;
+		long _memoized_matchups;
+};
+
+int deck_main(const std::vector<std::string> & arguments);
+
+#endif
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include "board.hh"
+#include "evaluator.hh"
+
+static const int EXPOSURE_WEIGHT = 24;
+static const int EDGE_WEIGHT = 4;
+static const int HAND_WEIGHT = 2;
+static const int ELEMENT_WEIGHT = 8;
+
+static const Direction OPPOSITE[4] = {SOUTH, NORTH, WEST, EAST};
+
+template <int Rows, int Columns>
+Evaluator::Evaluator(const BasicBoard<Rows, Columns> & board) :
+	_sides(board._catalog->list.size() * 4),
+	_strengths(board._catalog->list.size()),
+	_elements(board._catalog->list.size()),
+	_neighbors(board._squares.size() * 4, -1),
+	_edges(board._squares.size())
+{
+	for (auto & card : board._catalog->list)
+	{
+		_sides[card->index * 4 + NORTH] = card->top;
+		_sides[card->index * 4 + SOUTH] = card->bottom;
+		_sides[card->index * 4 + EAST] = card->right;
+		_sides[card->index * 4 + WEST] = card->left;
+
+		_strengths[card->index] = card->top + card->bottom + card->left + card->right;
+		_elements[card->index] = card->element;
+	}
+
+	for (auto & square : board._squares)
+	{
+		for (int direction = NORTH; direction <= WEST; direction++)
+		{
+			auto neighbor = square->get_neighbor(static_cast<Direction>(direction));
+
+			if (neighbor)
+				_neighbors[square->index * 4 + direction] = neighbor->index;
+			else
+				_edges[square->index]++;
+		}
+	}
+
+	/*
+	 * A side facing direction d is beaten by a card placed on that side whose
+	 * opposite side is greater.
+	 */
+	for (int direction = NORTH; direction <= WEST; direction++)
+	{
+		for (int value = 0; value < 12; value++)
+		{
+			int stronger = 0;
+
+			for (auto & card : board._catalog->list)
+			{
+				if (_sides[card->index * 4 + OPPOSITE[direction]] > value)
+					stronger++;
+			}
+
+			_weaknesses[direction][value] = EXPOSURE_WEIGHT * stronger / std::max<int>(1, board._catalog->list.size());
+		}
+	}
+}
+
+template <int Rows, int Columns>
+int Evaluator::evaluate(const BasicBoard<Rows, Columns> & board, Player player) const
+{
+	int score = 0;
+
+	for (auto & square : board._squares)
+	{
+		if (!square->card)
+			continue;
+
+		int card = square->card->index;
+		int sign = square->owner == player ? 1 : -1;
+		int value = SCALE + EDGE_WEIGHT * _edges[square->index];
+
+		int adjustment = 0;
+
+		if (board._elemental && square->element != ELEMENT_NONE)
+			adjustment = square->element == _elements[card] ? 1 : -1;
+
+		for (int direction = NORTH; direction <= WEST; direction++)
+		{
+			int neighbor = _neighbors[square->index * 4 + direction];
+
+			if (neighbor >= 0 && !board._squares[neighbor]->card)
+				value -= _weaknesses[direction][std::max(0, std::min(11, _sides[card * 4 + direction] + adjustment))];
+		}
+
+		score += sign * value;
+	}
+
+	int empty = board._empty_count;
+
+	for (int hand = PLAYER_RED; hand <= PLAYER_BLUE; hand++)
+	{
+		int sign = hand == player ? 1 : -1;
+		int moves = (empty + (hand == board._current_player ? 1 : 0)) / 2;
+
+		int cards = 0;
+		int strength = 0;
+		int fit = 0;
+
+		for (auto & pair : board._unplayed_cards[hand])
+		{
+			if (pair.second == 0)
+				continue;
+
+			cards += pair.second;
+			strength += pair.second * _strengths[pair.first->index];
+
+			if (board._elemental && pair.first->element != ELEMENT_NONE)
+			{
+				for (auto & square : board._squares)
+				{
+					if (!square->card && square->element == pair.first->element)
+						fit++;
+				}
+			}
+		}
+
+		score += sign * SCALE * (board._unplayed_card_counts[hand]);
+
+		if (cards > 0)
+			score += sign * (HAND_WEIGHT * (strength * moves / cards - 20 * moves) + ELEMENT_WEIGHT * std::min(fit, moves));
+	}
+
+	int limit = (board.get_score_bound() - 1) * SCALE;
+
+	return std::max(-limit, std::min(limit, score));
+}
+
+template Evaluator::Evaluator(const BasicBoard<3, 3> & board);
+template Evaluator::Evaluator(const BasicBoard<4, 4> & board);
+template Evaluator::Evaluator(const BasicBoard<5, 5> & board);
+
+template int Evaluator::evaluate(const BasicBoard<3, 3> & board, Player player) const;
+template int Evaluator::evaluate(const BasicBoard<4, 4> & board, Player player) const;
+template int Evaluator::evaluate(const BasicBoard<5, 5> & board, Player player) const;
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_EVALUATOR_HH
+#define TRIPLETRIAD_EVALUATOR_HH
+
+#include <vector>
+
+#include "common.hh"
+
+template <int Rows, int Columns>
+class BasicBoard;
+
+/*
+ * Static evaluation of unfinished positions, for searches that stop before the
+ * end of the game. Values are in units of 1/SCALE of a card, from the given
+ * player's perspective, and combine the card count with:
+ *
+ *   side exposure     placed cards lose value for each side facing an empty
+ *                     square, by how many cards in the catalog could beat it
+ *   corner control    placed cards gain value for each side at the edge
+ *   hand strength     the average side total of each hand, times the number
+ *                     of cards the player still has to place
+ *   elemental fit     cards in hand matching an empty square's element
+ *
+ * Everything that depends only on the catalog and board layout is computed
+ * once, when the evaluator is created.
+ */
+class Evaluator
+{
+	public:
+		template <int Rows, int Columns>
+		explicit Evaluator(const BasicBoard<Rows, Columns> & board);
+
+		template <int Rows, int Columns>
+		int evaluate(const BasicBoard<Rows, Columns> & board, Player player) const;
+
+		static const int SCALE = 64;
+
+	private:
+		std::vector<int> _sides;
+		std::vector<int> _strengths;
+		std::vector<int> _elements;
+
+		std::vector<int> _neighbors;
+		std::vector<int> _edges;
+
+		int _weaknesses[4][12];
+};
+
+#endif
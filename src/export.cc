@@ -0,0 +1,398 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include <unistd.h>
+
+#include "export.hh"
+#include "options.hh"
+
+static const char FILE_MAGIC[8] = {'T', 'T', 'E', 'X', 'P', 'O', 'R', 'T'};
+static const char CHUNK_MAGIC[4] = {'C', 'H', 'N', 'K'};
+
+static const int FILE_HEADER_SIZE = 32;
+static const int CHUNK_HEADER_SIZE = 16;
+static const int VERSION = 2;
+static const int MOVE_SLOTS = 45;
+
+static void _put_u32(unsigned char * bytes, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+		bytes[i] = value >> (8 * i);
+}
+
+static uint32_t _get_u32(const unsigned char * bytes)
+{
+	uint32_t value = 0;
+
+	for (int i = 0; i < 4; i++)
+		value |= static_cast<uint32_t>(bytes[i]) << (8 * i);
+
+	return value;
+}
+
+static uint32_t _checksum(const unsigned char * bytes, size_t size)
+{
+	uint32_t hash = 2166136261u;
+
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 16777619u;
+
+	return hash;
+}
+
+Exporter::Exporter(const std::string & path, int minimum_level, int maximum_level, int minimum_plies, int maximum_plies, bool elemental, bool moves, unsigned int seed) :
+	_path(path),
+	_minimum_level(minimum_level),
+	_maximum_level(maximum_level),
+	_minimum_plies(minimum_plies),
+	_maximum_plies(maximum_plies),
+	_elemental(elemental),
+	_moves(moves),
+	_seed(seed),
+	_file(nullptr),
+	_failed(false),
+	_existing_chunks(0),
+	_chunks(0),
+	_next_chunk(0),
+	_next_write(0)
+{ }
+
+/*
+ * Extends the file to the given number of chunks, keeping any complete chunks
+ * already written and discarding a trailing partial one. Returns false, with
+ * the reason in get_error, if the file cannot be opened or resumed or a write
+ * fails.
+ */
+bool Exporter::run(long chunks, int threads)
+{
+	if (!_open())
+	{
+		if (_file)
+			std::fclose(_file);
+
+		_file = nullptr;
+
+		return false;
+	}
+
+	_chunks = chunks;
+	_next_chunk = _existing_chunks;
+	_next_write = _existing_chunks;
+
+	std::vector<std::thread> workers;
+
+	for (int thread = 0; thread < threads; thread++)
+		workers.push_back(std::thread(&Exporter::_run_thread, this));
+
+	for (auto & worker : workers)
+		worker.join();
+
+	if (std::fclose(_file) != 0 && !_failed)
+	{
+		_error = "Cannot write " + _path;
+		_failed = true;
+	}
+
+	_file = nullptr;
+
+	return !_failed;
+}
+
+long Exporter::get_existing_chunks() const
+{
+	return _existing_chunks;
+}
+
+const std::string & Exporter::get_error() const
+{
+	return _error;
+}
+
+bool Exporter::_open()
+{
+	unsigned char header[FILE_HEADER_SIZE];
+
+	std::memcpy(header, FILE_MAGIC, 8);
+	_put_u32(header + 8, VERSION);
+	_put_u32(header + 12, (_moves ? 1 : 0) | (_elemental ? 2 : 0));
+	_put_u32(header + 16, _get_record_size());
+	_put_u32(header + 20, CHUNK_RECORDS);
+	_put_u32(header + 24, _seed);
+	header[28] = _minimum_level;
+	header[29] = _maximum_level;
+	header[30] = _minimum_plies;
+	header[31] = _maximum_plies;
+
+	_file = std::fopen(_path.c_str(), "r+b");
+
+	if (!_file)
+	{
+		_file = std::fopen(_path.c_str(), "w+b");
+
+		if (!_file || std::fwrite(header, FILE_HEADER_SIZE, 1, _file) != 1)
+		{
+			_error = "Cannot open " + _path;
+			return false;
+		}
+
+		_existing_chunks = 0;
+
+		return true;
+	}
+
+	unsigned char existing[FILE_HEADER_SIZE];
+
+	if (std::fread(existing, FILE_HEADER_SIZE, 1, _file) != 1 || std::memcmp(existing, header, FILE_HEADER_SIZE) != 0)
+	{
+		_error = "Cannot resume " + _path + ": its header does not match the version or settings";
+		return false;
+	}
+
+	long chunk_size = CHUNK_HEADER_SIZE + static_cast<long>(CHUNK_RECORDS) * _get_record_size();
+	std::vector<unsigned char> buffer(chunk_size);
+
+	_existing_chunks = 0;
+
+	while (std::fread(buffer.data(), chunk_size, 1, _file) == 1)
+	{
+		if (std::memcmp(buffer.data(), CHUNK_MAGIC, 4) != 0 || _get_u32(buffer.data() + 4) != _existing_chunks || _get_u32(buffer.data() + 12) != _checksum(buffer.data() + CHUNK_HEADER_SIZE, chunk_size - CHUNK_HEADER_SIZE))
+			break;
+
+		_existing_chunks++;
+	}
+
+	long size = FILE_HEADER_SIZE + _existing_chunks * chunk_size;
+
+	std::fflush(_file);
+
+	if (ftruncate(fileno(_file), size) != 0 || std::fseek(_file, size, SEEK_SET) != 0)
+	{
+		_error = "Cannot truncate " + _path;
+		return false;
+	}
+
+	return true;
+}
+
+void Exporter::_run_thread()
+{
+	Board board(PLAYER_RED, _elemental);
+	Dealer dealer(board, _minimum_level, _maximum_level, _elemental);
+
+	std::vector<unsigned char> buffer;
+
+	for (long chunk = _next_chunk++; chunk < _chunks && !_failed; chunk = _next_chunk++)
+	{
+		_fill_chunk(board, dealer, chunk, buffer);
+
+		if (!_write_chunk(chunk, buffer))
+			break;
+	}
+}
+
+/*
+ * Samples positions by dealing random hands and playing a random number of
+ * random moves, then solves each one exactly.
+ */
+void Exporter::_fill_chunk(Board & board, const Dealer & dealer, long chunk, std::vector<unsigned char> & buffer)
+{
+	std::seed_seq seed{static_cast<unsigned int>(_seed), static_cast<unsigned int>(chunk), static_cast<unsigned int>(chunk >> 32)};
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<int> plies_distribution(_minimum_plies, _maximum_plies);
+
+	std::vector<std::shared_ptr<Card>> hands[2];
+
+	int record_size = _get_record_size();
+
+	buffer.assign(CHUNK_HEADER_SIZE + static_cast<size_t>(CHUNK_RECORDS) * record_size, 0);
+
+	std::memcpy(buffer.data(), CHUNK_MAGIC, 4);
+	_put_u32(buffer.data() + 4, chunk);
+	_put_u32(buffer.data() + 8, CHUNK_RECORDS);
+
+	for (int record = 0; record < CHUNK_RECORDS; record++)
+	{
+		unsigned char * bytes = buffer.data() + CHUNK_HEADER_SIZE + static_cast<size_t>(record) * record_size;
+
+		board.get_transposition_table()->next_generation();
+		dealer.deal(board, random, hands);
+
+		for (int plies = plies_distribution(random); plies > 0; plies--)
+		{
+			auto moves = board.get_moves();
+			board.move(moves[std::uniform_int_distribution<size_t>(0, moves.size() - 1)(random)], false);
+		}
+
+		Position position;
+		board.encode(position);
+		position.to_bytes(bytes);
+
+		std::vector<int> cards;
+
+		for (auto & move : board.get_moves())
+		{
+			if (std::find(cards.begin(), cards.end(), move->card->index) == cards.end())
+				cards.push_back(move->card->index);
+		}
+
+		std::sort(cards.begin(), cards.end());
+
+		if (_moves)
+		{
+			auto analysis = board.analyze_moves(true);
+
+			std::memset(bytes + 18, 0x80, MOVE_SLOTS);
+
+			for (auto & entry : analysis)
+			{
+				int slot = std::find(cards.begin(), cards.end(), entry.move->card->index) - cards.begin();
+				bytes[18 + entry.move->square->index * 5 + slot] = static_cast<int8_t>(entry.score);
+			}
+
+			bytes[16] = static_cast<int8_t>(analysis[0].score);
+			bytes[17] = analysis[0].move->square->index * 5 + (std::find(cards.begin(), cards.end(), analysis[0].move->card->index) - cards.begin());
+		}
+		else
+		{
+			int score;
+			int positions = 0;
+
+			auto move = board.find_move(board.get_empty_count(), score, positions);
+
+			bytes[16] = static_cast<int8_t>(score);
+			bytes[17] = move->square->index * 5 + (std::find(cards.begin(), cards.end(), move->card->index) - cards.begin());
+		}
+	}
+
+	_put_u32(buffer.data() + 12, _checksum(buffer.data() + CHUNK_HEADER_SIZE, buffer.size() - CHUNK_HEADER_SIZE));
+}
+
+/*
+ * Chunks finish out of order across threads but are written in index order,
+ * so that the file is always a prefix of the complete export. A failed write
+ * stops the export, leaving at most a partial chunk that resuming discards.
+ */
+bool Exporter::_write_chunk(long chunk, std::vector<unsigned char> & buffer)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (_failed)
+		return false;
+
+	_pending[chunk].swap(buffer);
+
+	for (auto next = _pending.find(_next_write); next != _pending.end(); next = _pending.find(_next_write))
+	{
+		if (std::fwrite(next->second.data(), next->second.size(), 1, _file) != 1)
+			break;
+
+		_pending.erase(next);
+		_next_write++;
+	}
+
+	if (_pending.count(_next_write) || std::fflush(_file) != 0)
+	{
+		_error = "Cannot write " + _path;
+		_failed = true;
+	}
+
+	return !_failed;
+}
+
+int Exporter::_get_record_size() const
+{
+	return 18 + (_moves ? MOVE_SLOTS : 0);
+}
+
+int export_main(const std::vector<std::string> & arguments)
+{
+	if (arguments.size() < 2)
+	{
+		std::cout << "ERROR:    No output file given" << std::endl;
+		return 1;
+	}
+
+	long positions = 100000;
+	int minimum_plies = 2;
+	int maximum_plies = 8;
+	bool elemental = false;
+	bool moves = false;
+	unsigned int seed = 1;
+
+	BatchOptions options;
+
+	for (size_t i = 2; i < arguments.size(); i++)
+	{
+		if (options.parse(arguments, i))
+			continue;
+
+		if (arguments[i] == "elemental")
+			elemental = true;
+		else if (arguments[i] == "moves")
+			moves = true;
+		else if (i + 1 >= arguments.size())
+			break;
+		else if (arguments[i] == "positions")
+			positions = std::atol(arguments[++i].c_str());
+		else if (arguments[i] == "plies")
+			std::sscanf(arguments[++i].c_str(), "%d-%d", &minimum_plies, &maximum_plies);
+		else if (arguments[i] == "seed")
+			seed = std::atoi(arguments[++i].c_str());
+	}
+
+	if (!options.check())
+		return 1;
+
+	minimum_plies = std::max(0, std::min(minimum_plies, 8));
+	maximum_plies = std::max(minimum_plies, std::min(maximum_plies, 8));
+
+	long chunks = (positions + Exporter::CHUNK_RECORDS - 1) / Exporter::CHUNK_RECORDS;
+
+	Exporter exporter(arguments[1], options.minimum_level, options.maximum_level, minimum_plies, maximum_plies, elemental, moves, seed);
+
+	auto start = std::chrono::steady_clock::now();
+
+	if (!exporter.run(chunks, options.threads))
+	{
+		std::cout << "ERROR:    " << exporter.get_error() << std::endl;
+		return 1;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	long written = std::max(0l, chunks - exporter.get_existing_chunks()) * Exporter::CHUNK_RECORDS;
+
+	std::cout << std::left << std::fixed << std::setprecision(0) << "EXPORT:   ";
+	std::cout << std::setw(9) << "Records:" << std::setw(12) << std::max(chunks, exporter.get_existing_chunks()) * Exporter::CHUNK_RECORDS;
+	std::cout << std::setw(9) << "Written:" << std::setw(12) << written;
+	std::cout << std::setw(11) << "Records/s:" << std::setw(12) << written / seconds;
+	std::cout << std::endl;
+
+	return 0;
+}
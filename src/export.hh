@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_EXPORT_HH
+#define TRIPLETRIAD_EXPORT_HH
+
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "board.hh"
+#include "dealer.hh"
+
+/*
+ * Writes solved positions to a binary file for training evaluators. The file
+ * is a 32 byte header followed by chunks of a fixed number of records; all
+ * integers are little-endian.
+ *
+ * Header: "TTEXPORT", version (u32), flags (u32, bit 0 set if records hold
+ * per-move scores, bit 1 for the elemental rule), record size (u32), records
+ * per chunk (u32), seed (u32), and the minimum and maximum card levels and
+ * random plies (u8 each).
+ *
+ * Chunk: "CHNK", chunk index (u32), record count (u32) and the FNV-1a hash of
+ * the records (u32), followed by the records.
+ *
+ * Record: the position (16 bytes, see position.hh), its exact score for the
+ * player to move (i8) and the best move (u8). With per-move scores, 45 more
+ * bytes (i8) follow, with -128 marking illegal moves. Moves are numbered as
+ * square index * 5 + slot, where slot is the card's rank among the distinct
+ * cards in the mover's hand in ascending index order.
+ *
+ * Each chunk is generated from its own seed, so an interrupted export can be
+ * resumed by appending to the same file and produces the same records. The
+ * header holds every setting the records depend on, and resuming with any
+ * different setting is refused.
+ */
+class Exporter
+{
+	public:
+		Exporter(const std::string & path, int minimum_level, int maximum_level, int minimum_plies, int maximum_plies, bool elemental, bool moves, unsigned int seed);
+
+		bool run(long chunks, int threads);
+
+		long get_existing_chunks() const;
+		const std::string & get_error() const;
+
+		static const int CHUNK_RECORDS = 1024;
+
+	private:
+		bool _open();
+		void _run_thread();
+		void _fill_chunk(Board & board, const Dealer & dealer, long chunk, std::vector<unsigned char> & buffer);
+		bool _write_chunk(long chunk, std::vector<unsigned char> & buffer);
+
+		int _get_record_size() const;
+
+		std::string _path;
+
+		int _minimum_level;
+		int _maximum_level;
+		int _minimum_plies;
+		int _maximum_plies;
+
+		bool _elemental;
+		bool _moves;
+
+		unsigned int _seed;
+
+		std::FILE * _file;
+		std::string _error;
+		std::atomic<bool> _failed;
+
+		long _existing_chunks;
+		long _chunks;
+		std::atomic<long> _next_chunk;
+		long _next_write;
+
+		std::mutex _mutex;
+		std::map<long, std::vector<unsigned char>> _pending;
+};
+
+int export_main(const std::vector<std::string> & arguments);
+
+#endif
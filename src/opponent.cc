@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "opponent.hh"
+
+OpponentModel::~OpponentModel()
+{ }
+
+/*
+ * Creates a model from its name: "random", "greedy" or "greedy:NOISE", with the
+ * noise between 0 and 1. Returns nullptr for unknown names and invalid noise.
+ */
+std::shared_ptr<OpponentModel> OpponentModel::create(const std::string & name)
+{
+	if (name == "random")
+		return std::make_shared<RandomOpponentModel>();
+	else if (name == "greedy")
+		return std::make_shared<GreedyOpponentModel>(0.0);
+	else if (name.compare(0, 7, "greedy:") != 0)
+		return nullptr;
+
+	const char * text = name.c_str() + 7;
+	char * end;
+	double noise = std::strtod(text, &end);
+
+	if (end == text || *end != '\0' || !(noise >= 0.0 && noise <= 1.0))
+		return nullptr;
+
+	return std::make_shared<GreedyOpponentModel>(noise);
+}
+
+void RandomOpponentModel::get_probabilities(const std::vector<int> & flips, std::vector<double> & probabilities) const
+{
+	probabilities.assign(flips.size(), 1.0 / flips.size());
+}
+
+GreedyOpponentModel::GreedyOpponentModel(double noise) :
+	_noise(noise)
+{ }
+
+void GreedyOpponentModel::get_probabilities(const std::vector<int> & flips, std::vector<double> & probabilities) const
+{
+	int best_flips = *std::max_element(flips.begin(), flips.end());
+	int ties = std::count(flips.begin(), flips.end(), best_flips);
+
+	probabilities.resize(flips.size());
+
+	for (size_t i = 0; i < flips.size(); i++)
+		probabilities[i] = _noise / flips.size() + (flips[i] == best_flips ? (1.0 - _noise) / ties : 0.0);
+}
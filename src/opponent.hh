@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_OPPONENT_HH
+#define TRIPLETRIAD_OPPONENT_HH
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * A model of how an imperfect opponent chooses its moves, as a probability for
+ * each legal move. Moves are described by the number of cards they flip, so
+ * models work on any size of board.
+ */
+class OpponentModel
+{
+	public:
+		virtual ~OpponentModel();
+
+		virtual void get_probabilities(const std::vector<int> & flips, std::vector<double> & probabilities) const = 0;
+
+		static std::shared_ptr<OpponentModel> create(const std::string & name);
+};
+
+class RandomOpponentModel : public OpponentModel
+{
+	public:
+		void get_probabilities(const std::vector<int> & flips, std::vector<double> & probabilities) const;
+};
+
+/*
+ * Plays one of the moves flipping the most cards, except that with probability
+ * noise it plays any move at all.
+ */
+class GreedyOpponentModel : public OpponentModel
+{
+	public:
+		explicit GreedyOpponentModel(double noise);
+
+		void get_probabilities(const std::vector<int> & flips, std::vector<double> & probabilities) const;
+
+	private:
+		double _noise;
+};
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#include <unistd.h>
+
+#include "options.hh"
+
+static const int MINIMUM_LEVEL = 1;
+static const int MAXIMUM_LEVEL = 10;
+
+BatchOptions::BatchOptions() :
+	threads(std::max(1u, std::thread::hardware_concurrency())),
+	minimum_level(MINIMUM_LEVEL),
+	maximum_level(MAXIMUM_LEVEL),
+	table_bits(0),
+	huge_pages(false)
+{ }
+
+/*
+ * Reads the option at i, if it is one of these, and leaves i at its last
+ * argument.
+ */
+bool BatchOptions::parse(const std::vector<std::string> & arguments, size_t & i)
+{
+	if (arguments[i] == "huge")
+	{
+		huge_pages = true;
+		return true;
+	}
+
+	if (i + 1 >= arguments.size())
+		return false;
+
+	if (arguments[i] == "threads")
+		threads = std::max(1, std::atoi(arguments[++i].c_str()));
+	else if (arguments[i] == "table")
+		table_bits = std::max(0, std::min(36, std::atoi(arguments[++i].c_str())));
+	else if (arguments[i] == "levels")
+	{
+		if (std::sscanf(arguments[++i].c_str(), "%d-%d", &minimum_level, &maximum_level) != 2)
+			minimum_level = maximum_level = 0;
+	}
+	else
+		return false;
+
+	return true;
+}
+
+/*
+ * Reports the first invalid option as an error.
+ */
+bool BatchOptions::check() const
+{
+	if (minimum_level < MINIMUM_LEVEL || minimum_level > maximum_level || maximum_level > MAXIMUM_LEVEL)
+	{
+		std::cout << "ERROR:    Levels must be a range within " << MINIMUM_LEVEL << "-" << MAXIMUM_LEVEL << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Creates the shared table asked for, if any. A table larger than physical
+ * memory, or one that cannot be mapped, is reported as an error.
+ */
+bool BatchOptions::create_table(std::shared_ptr<TranspositionTable> & table) const
+{
+	if (table_bits == 0)
+		return true;
+
+	double size = TranspositionTable::get_size(table_bits);
+	double memory = static_cast<double>(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGE_SIZE);
+
+	if (memory > 0.0 && size > memory)
+	{
+		std::cout << "ERROR:    A table of " << table_bits << " bits needs " << size / (1 << 30) << " GiB, more than physical memory" << std::endl;
+		return false;
+	}
+
+	try
+	{
+		table = std::make_shared<TranspositionTable>(table_bits, huge_pages);
+	}
+	catch (const std::bad_alloc &)
+	{
+		std::cout << "ERROR:    Cannot allocate a table of " << table_bits << " bits" << std::endl;
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_OPTIONS_HH
+#define TRIPLETRIAD_OPTIONS_HH
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "transposition.hh"
+
+/*
+ * Options common to the batch commands: threads N, levels MIN-MAX, table BITS
+ * and huge. Each command reads its own options and hands the rest to parse.
+ */
+struct BatchOptions
+{
+	BatchOptions();
+
+	bool parse(const std::vector<std::string> & arguments, size_t & i);
+	bool check() const;
+
+	bool create_table(std::shared_ptr<TranspositionTable> & table) const;
+
+	int threads;
+
+	int minimum_level;
+	int maximum_level;
+
+	int table_bits;
+	bool huge_pages;
+};
+
+#endif
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "options.hh"
+#include "perft.hh"
+
+/*
+ * Reference counts, checked by an independent implementation of the rules.
+ * Red holds Squall, Gilgamesh, Ultima Weapon, Gayla and Cockatrice, and blue
+ * holds Zell, Angelo, Red Giant, Fastitocalon-F and Bite Bug, with red to
+ * move. The second position adds thunder, earth and holy elements to the
+ * top left, centre and bottom middle squares, and the third follows it with
+ * Gilgamesh in the centre and Angelo above it.
+ */
+struct PerftReference
+{
+	const char * position;
+	int depth;
+	long leaves;
+	long flips;
+};
+
+static const PerftReference REFERENCES[] = {
+	{ "000c93240705a26ca1416d0000000000", 1, 45, 0 },
+	{ "000c93240705a26ca1416d0000000000", 2, 1800, 252 },
+	{ "000c93240705a26ca1416d0000000000", 3, 50400, 8359 },
+	{ "000c93240705a26ca1416d0000000000", 4, 1209600, 343536 },
+	{ "000c93240705a26ca1416d0000000000", 5, 18144000, 6007264 },
+	{ "000c93240705a26ca1416d0009216fc2", 1, 45, 0 },
+	{ "000c93240705a26ca1416d0009216fc2", 2, 1800, 269 },
+	{ "000c93240705a26ca1416d0009216fc2", 3, 50400, 8343 },
+	{ "000c93240705a26ca1416d0009216fc2", 4, 1209600, 364342 },
+	{ "000c93240705a26ca1416d0009216fc2", 5, 18144000, 6007416 },
+	{ "0032480e0b44a14164cdcc0909216fc2", 1, 28, 7 },
+	{ "0032480e0b44a14164cdcc0909216fc2", 2, 672, 101 },
+	{ "0032480e0b44a14164cdcc0909216fc2", 3, 10080, 3648 },
+	{ "0032480e0b44a14164cdcc0909216fc2", 4, 120960, 36600 },
+	{ "0032480e0b44a14164cdcc0909216fc2", 5, 725760, 344088 },
+	{ "0032480e0b44a14164cdcc0909216fc2", 6, 2903040, 1326240 },
+	{ "0032480e0b44a14164cdcc0909216fc2", 7, 2903040, 1702944 }
+};
+
+PerftResult::PerftResult() :
+	leaves(0),
+	flips(0)
+{ }
+
+void PerftResult::merge(const PerftResult & other)
+{
+	leaves += other.leaves;
+	flips += other.flips;
+}
+
+Perft::Perft(const Position & position) :
+	_board(PLAYER_RED, false),
+	_valid(_board.decode(position))
+{ }
+
+bool Perft::is_valid() const
+{
+	return _valid;
+}
+
+PerftResult Perft::run(int depth, int threads)
+{
+	PerftResult total;
+
+	if (depth <= 1 || _board.get_empty_count() <= 1)
+	{
+		_board.perft(depth, total.leaves, total.flips);
+		return total;
+	}
+
+	_moves = _board.get_moves();
+
+	std::vector<PerftResult> results(threads);
+	std::vector<std::thread> workers;
+
+	for (int thread = 0; thread < threads; thread++)
+		workers.push_back(std::thread(&Perft::_run_thread, this, depth, threads, thread, std::ref(results[thread])));
+
+	for (int thread = 0; thread < threads; thread++)
+	{
+		workers[thread].join();
+		total.merge(results[thread]);
+	}
+
+	return total;
+}
+
+/*
+ * The root moves belong to the shared board, which is not changed while the
+ * threads run, so each is found again on the fork by square and card name.
+ */
+void Perft::_run_thread(int depth, int threads, int thread, PerftResult & result)
+{
+	auto board = _board.fork();
+	auto snapshot = board->snapshot();
+
+	PerftResult local;
+
+	for (size_t i = thread; i < _moves.size(); i += threads)
+	{
+		auto & move = _moves[i];
+
+		board->move(board->get_move(move->square->row, move->square->column, move->card->name), false);
+		board->perft(depth - 1, local.leaves, local.flips);
+		board->restore(snapshot);
+	}
+
+	result = local;
+}
+
+static bool run_perft(const Position & position, int depth, int threads, const PerftReference * reference)
+{
+	Perft perft(position);
+
+	if (!perft.is_valid())
+	{
+		std::cout << "WARNING:  Position cannot be decoded: " << position << std::endl;
+		return false;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	auto result = perft.run(depth, threads);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	bool correct = !reference || (result.leaves == reference->leaves && result.flips == reference->flips);
+
+	std::cout << std::left << std::fixed << "PERFT:    ";
+	std::cout << std::setw(10) << "Position:" << std::setw(34) << position;
+	std::cout << std::setw(7) << "Depth:" << std::setw(4) << depth;
+	std::cout << std::setw(8) << "Leaves:" << std::setw(12) << result.leaves;
+	std::cout << std::setw(7) << "Flips:" << std::setw(12) << result.flips;
+	std::cout << std::setw(9) << "Seconds:" << std::setw(9) << std::setprecision(3) << seconds;
+	std::cout << std::setw(10) << "Leaves/s:" << std::setw(12) << std::setprecision(0) << result.leaves / std::max(1e-9, seconds);
+
+	if (reference)
+		std::cout << std::setw(7) << "Check:" << (correct ? "OK" : "FAILED");
+
+	std::cout << std::endl;
+
+	return correct;
+}
+
+/*
+ * With a position, counts to each depth up to the one given, which defaults
+ * to the end of the game. Without one, checks the reference counts up to that
+ * depth.
+ */
+int perft_main(const std::vector<std::string> & arguments)
+{
+	Position position;
+	bool given = false;
+	int depth = 9;
+	BatchOptions options;
+
+	for (size_t i = 1; i < arguments.size(); i++)
+	{
+		if (options.parse(arguments, i))
+			continue;
+
+		if (Position::parse(arguments[i], position))
+			given = true;
+		else if (i + 1 >= arguments.size())
+			break;
+		else if (arguments[i] == "depth")
+			depth = std::atoi(arguments[++i].c_str());
+	}
+
+	bool correct = true;
+
+	if (given)
+	{
+		Board board(PLAYER_RED, false);
+
+		if (board.decode(position))
+			depth = std::min(depth, board.get_empty_count());
+
+		for (int i = 1; i <= depth; i++)
+			correct = run_perft(position, i, options.threads, nullptr) && correct;
+	}
+	else
+	{
+		for (auto & reference : REFERENCES)
+		{
+			if (reference.depth > depth)
+				continue;
+
+			Position::parse(reference.position, position);
+			correct = run_perft(position, reference.depth, options.threads, &reference) && correct;
+		}
+	}
+
+	return correct ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_PERFT_HH
+#define TRIPLETRIAD_PERFT_HH
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "board.hh"
+#include "position.hh"
+
+struct PerftResult
+{
+	PerftResult();
+
+	void merge(const PerftResult & other);
+
+	long leaves;
+	long flips;
+};
+
+/*
+ * Counts the leaves and flips below a position with Board::perft. The moves
+ * at the root are divided between threads, each playing them on its own fork
+ * of the board, so the counts do not depend on the number of threads.
+ */
+class Perft
+{
+	public:
+		Perft(const Position & position);
+
+		bool is_valid() const;
+
+		PerftResult run(int depth, int threads);
+
+	private:
+		void _run_thread(int depth, int threads, int thread, PerftResult & result);
+
+		Board _board;
+		bool _valid;
+
+		std::vector<std::shared_ptr<Move>> _moves;
+};
+
+int perft_main(const std::vector<std::string> & arguments);
+
+#endif
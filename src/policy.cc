@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdlib>
+
+#include "policy.hh"
+
+template <int Rows, int Columns>
+BasicPolicy<Rows, Columns>::~BasicPolicy()
+{ }
+
+/*
+ * Creates a policy from its name: "random", "greedy", "solver", "depth:N" for a
+ * search of N plies, or "expectimax:MODEL" or "winmax:MODEL" to maximize the
+ * expected margin or outcome against an opponent model (see OpponentModel).
+ * Returns nullptr for unknown names.
+ */
+template <int Rows, int Columns>
+std::shared_ptr<BasicPolicy<Rows, Columns>> BasicPolicy<Rows, Columns>::create(const std::string & name)
+{
+	if (name == "random")
+		return std::make_shared<RandomPolicy<Rows, Columns>>();
+	else if (name == "greedy")
+		return std::make_shared<GreedyPolicy<Rows, Columns>>();
+	else if (name == "solver")
+		return std::make_shared<SolverPolicy<Rows, Columns>>();
+	else if (name.compare(0, 6, "depth:") == 0 && std::atoi(name.c_str() + 6) > 0)
+		return std::make_shared<DepthPolicy<Rows, Columns>>(std::atoi(name.c_str() + 6));
+	else if (name.compare(0, 11, "expectimax:") == 0 && OpponentModel::create(name.substr(11)))
+		return std::make_shared<ExpectimaxPolicy<Rows, Columns>>(OpponentModel::create(name.substr(11)), OBJECTIVE_MARGIN);
+	else if (name.compare(0, 7, "winmax:") == 0 && OpponentModel::create(name.substr(7)))
+		return std::make_shared<ExpectimaxPolicy<Rows, Columns>>(OpponentModel::create(name.substr(7)), OBJECTIVE_OUTCOME);
+	else
+		return nullptr;
+}
+
+template <int Rows, int Columns>
+std::shared_ptr<Move> RandomPolicy<Rows, Columns>::choose(BasicBoard<Rows, Columns> & board, std::mt19937 & random)
+{
+	auto moves = board.get_moves();
+
+	return moves[std::uniform_int_distribution<size_t>(0, moves.size() - 1)(random)];
+}
+
+/*
+ * Plays the move flipping the most cards immediately, choosing uniformly among
+ * ties.
+ */
+template <int Rows, int Columns>
+std::shared_ptr<Move> GreedyPolicy<Rows, Columns>::choose(BasicBoard<Rows, Columns> & board, std::mt19937 & random)
+{
+	std::shared_ptr<Move> best_move;
+
+	int best_flips = -1;
+	int ties = 0;
+
+	for (auto & move : board.get_moves())
+	{
+		int flips = board.count_flips(move);
+
+		if (flips > best_flips)
+		{
+			best_flips = flips;
+			best_move = move;
+			ties = 1;
+		}
+		else if (flips == best_flips && std::uniform_int_distribution<int>(0, ties++)(random) == 0)
+		{
+			best_move = move;
+		}
+	}
+
+	return best_move;
+}
+
+template <int Rows, int Columns>
+DepthPolicy<Rows, Columns>::DepthPolicy(int depth) :
+	_depth(depth)
+{ }
+
+template <int Rows, int Columns>
+std::shared_ptr<Move> DepthPolicy<Rows, Columns>::choose(BasicBoard<Rows, Columns> & board, std::mt19937 &)
+{
+	int score;
+	int positions = 0;
+
+	return board.find_move(_depth, score, positions);
+}
+
+template <int Rows, int Columns>
+std::shared_ptr<Move> SolverPolicy<Rows, Columns>::choose(BasicBoard<Rows, Columns> & board, std::mt19937 &)
+{
+	int score;
+	int positions = 0;
+
+	return board.find_move(board.get_empty_count(), score, positions);
+}
+
+template <int Rows, int Columns>
+ExpectimaxPolicy<Rows, Columns>::ExpectimaxPolicy(const std::shared_ptr<OpponentModel> & model, Objective objective) :
+	_model(model),
+	_objective(objective),
+	_empty_count(0)
+{ }
+
+template <int Rows, int Columns>
+std::shared_ptr<Move> ExpectimaxPolicy<Rows, Columns>::choose(BasicBoard<Rows, Columns> & board, std::mt19937 &)
+{
+	if (board.get_empty_count() >= _empty_count)
+		_cache.clear();
+
+	_empty_count = board.get_empty_count();
+
+	double value;
+	int positions = 0;
+
+	return board.find_move_expectimax(*_model, _objective, _cache, BUDGET, value, positions);
+}
+
+template class BasicPolicy<3, 3>;
+template class RandomPolicy<3, 3>;
+template class GreedyPolicy<3, 3>;
+template class DepthPolicy<3, 3>;
+template class SolverPolicy<3, 3>;
+template class ExpectimaxPolicy<3, 3>;
+
+template class BasicPolicy<4, 4>;
+template class RandomPolicy<4, 4>;
+template class GreedyPolicy<4, 4>;
+template class DepthPolicy<4, 4>;
+template class SolverPolicy<4, 4>;
+template class ExpectimaxPolicy<4, 4>;
+
+template class BasicPolicy<5, 5>;
+template class RandomPolicy<5, 5>;
+template class GreedyPolicy<5, 5>;
+template class DepthPolicy<5, 5>;
+template class SolverPolicy<5, 5>;
+template class ExpectimaxPolicy<5, 5>;
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_POLICY_HH
+#define TRIPLETRIAD_POLICY_HH
+
+#include <memory>
+#include <random>
+#include <string>
+
+#include "board.hh"
+#include "move.hh"
+#include "opponent.hh"
+
+/*
+ * A strategy for choosing moves, used by drivers that play games without a
+ * human. Policies may keep state, so each thread should create its own.
+ */
+template <int Rows, int Columns>
+class BasicPolicy
+{
+	public:
+		virtual ~BasicPolicy();
+
+		virtual std::shared_ptr<Move> choose(BasicBoard<Rows, Columns> & board, std::mt19937 & random) = 0;
+
+		static std::shared_ptr<BasicPolicy> create(const std::string & name);
+};
+
+template <int Rows, int Columns>
+class RandomPolicy : public BasicPolicy<Rows, Columns>
+{
+	public:
+		std::shared_ptr<Move> choose(BasicBoard<Rows, Columns> & board, std::mt19937 & random);
+};
+
+template <int Rows, int Columns>
+class GreedyPolicy : public BasicPolicy<Rows, Columns>
+{
+	public:
+		std::shared_ptr<Move> choose(BasicBoard<Rows, Columns> & board, std::mt19937 & random);
+};
+
+template <int Rows, int Columns>
+class DepthPolicy : public BasicPolicy<Rows, Columns>
+{
+	public:
+		explicit DepthPolicy(int depth);
+
+		std::shared_ptr<Move> choose(BasicBoard<Rows, Columns> & board, std::mt19937 & random);
+
+	private:
+		int _depth;
+};
+
+template <int Rows, int Columns>
+class SolverPolicy : public BasicPolicy<Rows, Columns>
+{
+	public:
+		std::shared_ptr<Move> choose(BasicBoard<Rows, Columns> & board, std::mt19937 & random);
+};
+
+/*
+ * Maximizes the expected result against an opponent following a model. Each
+ * move's search stops deepening once it has visited BUDGET positions, a fifth
+ * of an exact opening search, so no move runs the exact search as well. The
+ * cache of expected values is kept for the rest of a game.
+ */
+template <int Rows, int Columns>
+class ExpectimaxPolicy : public BasicPolicy<Rows, Columns>
+{
+	public:
+		ExpectimaxPolicy(const std::shared_ptr<OpponentModel> & model, Objective objective);
+
+		std::shared_ptr<Move> choose(BasicBoard<Rows, Columns> & board, std::mt19937 & random);
+
+		static const int BUDGET = 250000;
+
+	private:
+		std::shared_ptr<OpponentModel> _model;
+		Objective _objective;
+
+		ExpectimaxCache _cache;
+		int _empty_count;
+};
+
+typedef BasicPolicy<3, 3> Policy;
+
+#endif
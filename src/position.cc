@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <iomanip>
+#include <sstream>
+
+#include "position.hh"
+
+Position::Position() :
+	low(0),
+	high(0)
+{ }
+
+Position::Position(uint64_t low, uint64_t high) :
+	low(low),
+	high(high)
+{ }
+
+/*
+ * Writes the position as 16 little-endian bytes, independent of the host's
+ * byte order.
+ */
+void Position::to_bytes(unsigned char bytes[16]) const
+{
+	for (int i = 0; i < 8; i++)
+	{
+		bytes[i] = low >> (8 * i);
+		bytes[i + 8] = high >> (8 * i);
+	}
+}
+
+Position Position::from_bytes(const unsigned char bytes[16])
+{
+	Position position;
+
+	for (int i = 0; i < 8; i++)
+	{
+		position.low |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+		position.high |= static_cast<uint64_t>(bytes[i + 8]) << (8 * i);
+	}
+
+	return position;
+}
+
+/*
+ * Reads the 32 hexadecimal digit form written by operator<<.
+ */
+bool Position::parse(const std::string & text, Position & position)
+{
+	return parse(text.data(), text.data() + text.size(), position);
+}
+
+/*
+ * As above, for text that is not held in a string, such as a mapped file.
+ */
+bool Position::parse(const char * begin, const char * end, Position & position)
+{
+	if (end - begin != 32)
+		return false;
+
+	uint64_t words[2] = {0, 0};
+
+	for (int i = 0; i < 32; i++)
+	{
+		char c = begin[i];
+		int digit;
+
+		if (c >= '0' && c <= '9')
+			digit = c - '0';
+		else if (c >= 'a' && c <= 'f')
+			digit = c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F')
+			digit = c - 'A' + 10;
+		else
+			return false;
+
+		words[i / 16] = words[i / 16] << 4 | digit;
+	}
+
+	position.high = words[0];
+	position.low = words[1];
+
+	return true;
+}
+
+bool Position::operator==(const Position & other) const
+{
+	return low == other.low && high == other.high;
+}
+
+bool Position::operator!=(const Position & other) const
+{
+	return !(*this == other);
+}
+
+bool Position::operator<(const Position & other) const
+{
+	return high < other.high || (high == other.high && low < other.low);
+}
+
+std::ostream & operator<<(std::ostream & stream, const Position & position)
+{
+	std::ostringstream oss;
+	oss << std::hex << std::setfill('0') << std::setw(16) << position.high << std::setw(16) << position.low;
+
+	return stream << oss.str();
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_POSITION_HH
+#define TRIPLETRIAD_POSITION_HH
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+
+/*
+ * Canonical fixed-width encoding of a 3x3 position, produced by Board::encode
+ * and read back by Board::decode. Fields are packed from the least significant
+ * bit of low upwards:
+ *
+ *   1 bit    player to move
+ *   1 bit    elemental rule
+ *   29 bits  square elements, as a base 9 number with the first square last
+ *   9 bits   occupied squares
+ *   8 bits   per occupied square, in order: card index (7) and owner (1)
+ *   3 bits   red hand size
+ *   3 bits   blue hand size
+ *   7 bits   per card in hand, red then blue, each in ascending index order
+ *
+ * Unused bits are zero, so equal positions always have equal encodings. With
+ * five card hands this takes at most 125 bits.
+ */
+class Position
+{
+	public:
+		Position();
+		Position(uint64_t low, uint64_t high);
+
+		void to_bytes(unsigned char bytes[16]) const;
+		static Position from_bytes(const unsigned char bytes[16]);
+
+		static bool parse(const std::string & text, Position & position);
+		static bool parse(const char * begin, const char * end, Position & position);
+
+		bool operator==(const Position & other) const;
+		bool operator!=(const Position & other) const;
+		bool operator<(const Position & other) const;
+
+		friend std::ostream & operator<<(std::ostream & stream, const Position & position);
+
+		uint64_t low;
+		uint64_t high;
+};
+
+namespace std
+{
+	template <>
+	struct hash<Position>
+	{
+		size_t operator()(const Position & position) const
+		{
+			return position.low * UINT64_C(0x9e3779b97f4a7c15) ^ position.high;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include "reference.hh"
+
+ReferenceSolver::ReferenceSolver(const std::vector<std::shared_ptr<Card>> & cards) :
+	_cards(cards)
+{ }
+
+/*
+ * Scores every legal move of the position, one entry per distinct card and
+ * empty square, ordered by square and then card. Fails if the position does
+ * not decode.
+ */
+bool ReferenceSolver::solve(const Position & position, std::vector<ReferenceMove> & moves, long & positions) const
+{
+	State state;
+
+	moves.clear();
+
+	if (!_decode(position, state))
+		return false;
+
+	auto & hand = state.hands[state.player];
+
+	for (int square = 0; square < 9; square++)
+	{
+		if (state.cards[square] >= 0)
+			continue;
+
+		for (size_t i = 0; i < hand.size(); i++)
+		{
+			if (std::find(hand.begin(), hand.begin() + i, hand[i]) != hand.begin() + i)
+				continue;
+
+			State child = state;
+			_play(child, square, hand[i]);
+
+			ReferenceMove move;
+			move.square = square;
+			move.card = hand[i];
+			move.score = -_search(child, positions);
+
+			moves.push_back(move);
+			positions++;
+		}
+	}
+
+	std::sort(moves.begin(), moves.end(), [](const ReferenceMove & a, const ReferenceMove & b) {
+		return a.square != b.square ? a.square < b.square : a.card < b.card;
+	});
+
+	return true;
+}
+
+bool ReferenceSolver::_decode(const Position & position, State & state) const
+{
+	uint64_t words[2] = {position.low, position.high};
+	int offset = 0;
+
+	auto read = [&](int bits) {
+		uint64_t value = 0;
+
+		for (int bit = 0; bit < bits; bit++, offset++)
+			value |= ((words[offset / 64] >> (offset % 64)) & 1) << bit;
+
+		return value;
+	};
+
+	state.player = static_cast<Player>(read(1));
+	state.elemental = read(1);
+
+	uint64_t elements = read(29);
+	uint64_t occupied = read(9);
+
+	for (int square = 0; square < 9; square++)
+	{
+		state.elements[square] = elements % 9;
+		elements /= 9;
+	}
+
+	for (int square = 0; square < 9; square++)
+	{
+		state.cards[square] = -1;
+		state.owners[square] = -1;
+
+		if (occupied & (1 << square))
+		{
+			state.cards[square] = read(7);
+			state.owners[square] = read(1);
+
+			if (static_cast<size_t>(state.cards[square]) >= _cards.size())
+				return false;
+		}
+	}
+
+	int sizes[2];
+	sizes[PLAYER_RED] = read(3);
+	sizes[PLAYER_BLUE] = read(3);
+
+	for (int player = PLAYER_RED; player <= PLAYER_BLUE; player++)
+	{
+		state.hands[player].clear();
+
+		for (int i = 0; i < sizes[player]; i++)
+		{
+			if (offset + 7 > 128)
+				return false;
+
+			state.hands[player].push_back(read(7));
+
+			if (static_cast<size_t>(state.hands[player].back()) >= _cards.size())
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Places a card and flips every adjacent opposing card whose facing side,
+ * with elemental adjustments, is lower.
+ */
+void ReferenceSolver::_play(State & state, int square, int card) const
+{
+	auto & hand = state.hands[state.player];
+	hand.erase(std::find(hand.begin(), hand.end(), card));
+
+	state.cards[square] = card;
+	state.owners[square] = state.player;
+
+	int row = square / 3;
+	int column = square % 3;
+
+	const Card & source = *_cards[card];
+
+	for (int direction = 0; direction < 4; direction++)
+	{
+		int target_row = row + (direction == 0 ? -1 : (direction == 1 ? 1 : 0));
+		int target_column = column + (direction == 2 ? -1 : (direction == 3 ? 1 : 0));
+
+		if (target_row < 0 || target_row > 2 || target_column < 0 || target_column > 2)
+			continue;
+
+		int target = target_row * 3 + target_column;
+
+		if (state.cards[target] < 0 || state.owners[target] == state.player)
+			continue;
+
+		const Card & other = *_cards[state.cards[target]];
+
+		int attack = direction == 0 ? source.top : (direction == 1 ? source.bottom : (direction == 2 ? source.left : source.right));
+		int defense = direction == 0 ? other.bottom : (direction == 1 ? other.top : (direction == 2 ? other.right : other.left));
+
+		if (attack + _adjustment(state, square) > defense + _adjustment(state, target))
+			state.owners[target] = state.player;
+	}
+
+	state.player = state.player == PLAYER_RED ? PLAYER_BLUE : PLAYER_RED;
+}
+
+int ReferenceSolver::_adjustment(const State & state, int square) const
+{
+	if (!state.elemental || state.elements[square] == ELEMENT_NONE)
+		return 0;
+
+	return state.elements[square] == _cards[state.cards[square]]->element ? 1 : -1;
+}
+
+/*
+ * Plain negamax over every move, returning the final margin for the player to
+ * move.
+ */
+int ReferenceSolver::_search(const State & state, long & positions) const
+{
+	auto & hand = state.hands[state.player];
+
+	if (hand.empty() || std::find(state.cards, state.cards + 9, -1) == state.cards + 9)
+		return _evaluate(state);
+
+	int best = -100;
+
+	for (int square = 0; square < 9; square++)
+	{
+		if (state.cards[square] >= 0)
+			continue;
+
+		for (size_t i = 0; i < hand.size(); i++)
+		{
+			if (std::find(hand.begin(), hand.begin() + i, hand[i]) != hand.begin() + i)
+				continue;
+
+			State child = state;
+			_play(child, square, hand[i]);
+
+			best = std::max(best, -_search(child, positions));
+			positions++;
+		}
+	}
+
+	return best;
+}
+
+/*
+ * Each player scores the squares they own and the cards left in their hand.
+ */
+int ReferenceSolver::_evaluate(const State & state) const
+{
+	int scores[2] = {
+		static_cast<int>(state.hands[PLAYER_RED].size()),
+		static_cast<int>(state.hands[PLAYER_BLUE].size())
+	};
+
+	for (int square = 0; square < 9; square++)
+	{
+		if (state.owners[square] >= 0)
+			scores[state.owners[square]]++;
+	}
+
+	return scores[state.player] - scores[1 - state.player];
+}
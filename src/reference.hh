@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_REFERENCE_HH
+#define TRIPLETRIAD_REFERENCE_HH
+
+#include <memory>
+#include <vector>
+
+#include "card.hh"
+#include "common.hh"
+#include "position.hh"
+
+struct ReferenceMove
+{
+	int square;
+	int card;
+	int score;
+};
+
+/*
+ * A deliberately plain solver for 3x3 positions, kept as the reference that
+ * the optimized search is checked against. It reads the position encoding on
+ * its own, copies the state for every move instead of undoing moves, and
+ * searches the whole tree without pruning, ordering or a transposition table,
+ * so it is only practical for positions with a few empty squares.
+ *
+ * Scores are final margins from the perspective of the player to move, as
+ * with Board::analyze_moves.
+ */
+class ReferenceSolver
+{
+	public:
+		explicit ReferenceSolver(const std::vector<std::shared_ptr<Card>> & cards);
+
+		bool solve(const Position & position, std::vector<ReferenceMove> & moves, long & positions) const;
+
+	private:
+		struct State
+		{
+			Player player;
+			bool elemental;
+
+			int elements[9];
+			int cards[9];
+			int owners[9];
+
+			std::vector<int> hands[2];
+		};
+
+		bool _decode(const Position & position, State & state) const;
+		void _play(State & state, int square, int card) const;
+		int _adjustment(const State & state, int square) const;
+		int _search(const State & state, long & positions) const;
+		int _evaluate(const State & state) const;
+
+		std::vector<std::shared_ptr<Card>> _cards;
+};
+
+#endif
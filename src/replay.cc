@@ -0,0 +1,587 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "options.hh"
+#include "position.hh"
+#include "replay.hh"
+
+static bool is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+TranscriptSpan::TranscriptSpan() :
+	begin(nullptr),
+	end(nullptr)
+{ }
+
+TranscriptSpan::TranscriptSpan(const char * begin, const char * end) :
+	begin(begin),
+	end(end)
+{ }
+
+bool TranscriptSpan::empty() const
+{
+	return begin == end;
+}
+
+bool TranscriptSpan::operator==(const char * text) const
+{
+	size_t length = std::strlen(text);
+
+	return static_cast<size_t>(end - begin) == length && std::memcmp(begin, text, length) == 0;
+}
+
+/*
+ * Compares with a card name, treating any run of spaces in the transcript as
+ * the single space between words of the name.
+ */
+bool TranscriptSpan::matches(const std::string & name) const
+{
+	const char * cursor = begin;
+
+	for (size_t i = 0; i < name.size(); i++)
+	{
+		if (cursor == end)
+			return false;
+
+		if (name[i] == ' ')
+		{
+			if (!is_space(*cursor))
+				return false;
+
+			while (cursor != end && is_space(*cursor))
+				cursor++;
+		}
+		else if (*cursor++ != name[i])
+		{
+			return false;
+		}
+	}
+
+	return cursor == end;
+}
+
+static TranscriptSpan next_token(TranscriptSpan & rest)
+{
+	while (rest.begin != rest.end && is_space(*rest.begin))
+		rest.begin++;
+
+	const char * begin = rest.begin;
+
+	while (rest.begin != rest.end && !is_space(*rest.begin))
+		rest.begin++;
+
+	return TranscriptSpan(begin, rest.begin);
+}
+
+static TranscriptSpan trim(TranscriptSpan span)
+{
+	while (span.begin != span.end && is_space(*span.begin))
+		span.begin++;
+
+	while (span.end != span.begin && is_space(*(span.end - 1)))
+		span.end--;
+
+	return span;
+}
+
+static bool parse_int(const TranscriptSpan & span, int & value)
+{
+	if (span.empty() || span.end - span.begin > 4)
+		return false;
+
+	value = 0;
+
+	for (const char * c = span.begin; c != span.end; c++)
+	{
+		if (*c < '0' || *c > '9')
+			return false;
+
+		value = value * 10 + (*c - '0');
+	}
+
+	return true;
+}
+
+static bool parse_element(const TranscriptSpan & span, Element & element)
+{
+	static const char * NAMES[] = {"none", "fire", "ice", "thunder", "poison", "earth", "wind", "water", "holy"};
+
+	for (int i = ELEMENT_NONE; i <= ELEMENT_HOLY; i++)
+	{
+		if (span == NAMES[i])
+		{
+			element = static_cast<Element>(i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static int find_card(const std::vector<std::shared_ptr<Card>> & cards, const TranscriptSpan & name)
+{
+	for (size_t i = 0; i < cards.size(); i++)
+	{
+		if (name.matches(cards[i]->name))
+			return i;
+	}
+
+	return -1;
+}
+
+ReplayGame::ReplayGame() :
+	line(0),
+	error_line(0)
+{ }
+
+ReplayResult::ReplayResult() :
+	games(0),
+	invalid(0),
+	moves(0),
+	mistakes(0),
+	loss(0),
+	positions(0),
+	parse_seconds(0.0),
+	solve_seconds(0.0)
+{ }
+
+void ReplayResult::merge(const ReplayResult & other)
+{
+	games += other.games;
+	invalid += other.invalid;
+	moves += other.moves;
+	mistakes += other.mistakes;
+	loss += other.loss;
+	positions += other.positions;
+	parse_seconds += other.parse_seconds;
+	solve_seconds += other.solve_seconds;
+}
+
+/*
+ * Maps the transcript and finds where each game begins, without reading
+ * anything more than the first word of each line.
+ */
+ReplayAnalyzer::ReplayAnalyzer(const std::string & path) :
+	_open(false),
+	_data(nullptr),
+	_size(0)
+{
+	int descriptor = open(path.c_str(), O_RDONLY);
+
+	if (descriptor < 0)
+		return;
+
+	struct stat status;
+
+	if (fstat(descriptor, &status) == 0)
+	{
+		_open = true;
+
+		if (status.st_size > 0)
+		{
+			void * memory = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+			_open = memory != MAP_FAILED;
+
+			if (_open)
+			{
+				_data = static_cast<const char *>(memory);
+				_size = status.st_size;
+			}
+		}
+	}
+
+	close(descriptor);
+
+	const char * end = _data + _size;
+	long line = 1;
+
+	for (const char * cursor = _data; cursor < end; line++)
+	{
+		const char * eol = static_cast<const char *>(std::memchr(cursor, '\n', end - cursor));
+
+		if (!eol)
+			eol = end;
+
+		TranscriptSpan rest(cursor, eol);
+
+		if (next_token(rest) == "new")
+		{
+			_starts.push_back(cursor);
+			_games.push_back(ReplayGame());
+			_games.back().line = line;
+		}
+
+		cursor = eol == end ? end : eol + 1;
+	}
+}
+
+ReplayAnalyzer::~ReplayAnalyzer()
+{
+	if (_data)
+		munmap(const_cast<char *>(_data), _size);
+}
+
+bool ReplayAnalyzer::is_open() const
+{
+	return _open;
+}
+
+void ReplayAnalyzer::set_transposition_table(const std::shared_ptr<TranspositionTable> & table)
+{
+	_transposition_table = table;
+}
+
+ReplayResult ReplayAnalyzer::run(int threads)
+{
+	std::atomic<size_t> next(0);
+
+	std::vector<ReplayResult> results(threads);
+	std::vector<std::thread> workers;
+
+	for (int thread = 0; thread < threads; thread++)
+		workers.push_back(std::thread(&ReplayAnalyzer::_run_thread, this, std::ref(next), std::ref(results[thread])));
+
+	ReplayResult total;
+
+	for (int thread = 0; thread < threads; thread++)
+	{
+		workers[thread].join();
+		total.merge(results[thread]);
+	}
+
+	return total;
+}
+
+const std::vector<ReplayGame> & ReplayAnalyzer::get_games() const
+{
+	return _games;
+}
+
+/*
+ * Games are taken one at a time rather than in fixed shares, since the time
+ * to solve them varies widely with how far into the game the transcript
+ * starts.
+ */
+void ReplayAnalyzer::_run_thread(std::atomic<size_t> & next, ReplayResult & result)
+{
+	Board board(PLAYER_RED, false);
+	ReplayResult local;
+
+	if (_transposition_table)
+		board.set_transposition_table(_transposition_table);
+
+	for (size_t game = next++; game < _games.size(); game = next++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		double solve_seconds = local.solve_seconds;
+
+		local.games++;
+
+		/*
+		 * A private table ages once per game. A shared table ages once every
+		 * GENERATION_GAMES games, counted by the shared game index, whichever
+		 * thread takes the game.
+		 */
+		if (!_transposition_table || game % GENERATION_GAMES == 0)
+			board.get_transposition_table()->next_generation();
+
+		if (!_replay(board, game, local))
+			local.invalid++;
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		local.parse_seconds += seconds - (local.solve_seconds - solve_seconds);
+	}
+
+	result = local;
+}
+
+/*
+ * Plays the commands of one game in order. Each move is scored by the value
+ * of the position before it, which is the value of the best move, and the
+ * negated value of the position after it, so every position in the game is
+ * searched once.
+ */
+bool ReplayAnalyzer::_replay(Board & board, size_t game, ReplayResult & result)
+{
+	ReplayGame & record = _games[game];
+	const auto & cards = board.get_cards();
+
+	const char * cursor = _starts[game];
+	const char * end = game + 1 < _starts.size() ? _starts[game + 1] : _data + _size;
+
+	int hand_sizes[2] = {0, 0};
+	bool known = false;
+	int value = 0;
+
+	for (long line = record.line; cursor < end; line++)
+	{
+		const char * eol = static_cast<const char *>(std::memchr(cursor, '\n', end - cursor));
+
+		if (!eol)
+			eol = end;
+
+		TranscriptSpan rest(cursor, eol);
+		TranscriptSpan command = next_token(rest);
+
+		cursor = eol == end ? end : eol + 1;
+
+		bool valid = true;
+
+		if (command == "new")
+		{
+			Player first_player = next_token(rest) == "blue" ? PLAYER_BLUE : PLAYER_RED;
+			bool elemental = false;
+
+			for (auto token = next_token(rest); !token.empty(); token = next_token(rest))
+				elemental = elemental || token == "elemental";
+
+			board.reset(first_player, elemental);
+			hand_sizes[PLAYER_RED] = hand_sizes[PLAYER_BLUE] = 0;
+			known = false;
+		}
+		else if (command == "element")
+		{
+			int row, column;
+			Element element;
+
+			valid = parse_int(next_token(rest), row) && parse_int(next_token(rest), column) && parse_element(next_token(rest), element);
+			valid = valid && row >= 1 && row <= board.get_rows() && column >= 1 && column <= board.get_columns();
+
+			if (valid)
+				board.set_element(row - 1, column - 1, element);
+
+			known = false;
+		}
+		else if (command == "card")
+		{
+			TranscriptSpan side = next_token(rest);
+			Player player = side == "blue" ? PLAYER_BLUE : PLAYER_RED;
+			int card = find_card(cards, trim(rest));
+
+			valid = (side == "red" || side == "blue") && card >= 0 && hand_sizes[player] < Board::HAND_SIZE;
+
+			if (valid)
+			{
+				board.activate_card(player, cards[card]);
+				hand_sizes[player]++;
+			}
+
+			known = false;
+		}
+		else if (command == "position")
+		{
+			TranscriptSpan text = next_token(rest);
+			Position position;
+
+			valid = Position::parse(text.begin, text.end, position) && board.decode(position);
+
+			hand_sizes[PLAYER_RED] = hand_sizes[PLAYER_BLUE] = Board::HAND_SIZE;
+			known = false;
+		}
+		else if (command == "play")
+		{
+			int row, column;
+
+			valid = parse_int(next_token(rest), row) && parse_int(next_token(rest), column);
+			valid = valid && hand_sizes[PLAYER_RED] == Board::HAND_SIZE && hand_sizes[PLAYER_BLUE] == Board::HAND_SIZE;
+
+			int card = valid ? find_card(cards, trim(rest)) : -1;
+			std::shared_ptr<Move> played;
+
+			if (card >= 0)
+			{
+				for (auto & move : board.get_moves())
+				{
+					if (move->square->row == row - 1 && move->square->column == column - 1 && move->card == cards[card])
+						played = move;
+				}
+			}
+
+			valid = played != nullptr;
+
+			if (valid)
+			{
+				ReplayMove entry;
+				entry.player = board.get_current_player();
+				entry.row = row - 1;
+				entry.column = column - 1;
+				entry.card = card;
+				entry.best = known ? value : _solve(board, result);
+
+				board.move(played, false);
+
+				value = _solve(board, result);
+				known = true;
+
+				entry.played = -value;
+				record.moves.push_back(entry);
+
+				result.moves++;
+				result.loss += entry.best - entry.played;
+
+				if (entry.played < entry.best)
+					result.mistakes++;
+			}
+		}
+
+		if (!valid)
+		{
+			record.error_line = line;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * The exact value of the position for the player to move.
+ */
+int ReplayAnalyzer::_solve(Board & board, ReplayResult & result)
+{
+	Player player = board.get_current_player();
+	Player opponent = player == PLAYER_RED ? PLAYER_BLUE : PLAYER_RED;
+
+	if (board.is_complete())
+		return board.get_score(player) - board.get_score(opponent);
+
+	auto start = std::chrono::steady_clock::now();
+
+	int bound = board.get_score_bound();
+	int positions = 0;
+	int value = board.search(player, -bound, bound, positions);
+
+	result.positions += positions;
+	result.solve_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return value;
+}
+
+int replay_main(const std::vector<std::string> & arguments)
+{
+	if (arguments.size() < 2)
+	{
+		std::cout << "ERROR:    No transcript given" << std::endl;
+		return 1;
+	}
+
+	BatchOptions options;
+	bool quiet = false;
+
+	for (size_t i = 2; i < arguments.size(); i++)
+	{
+		if (options.parse(arguments, i))
+			continue;
+
+		if (arguments[i] == "quiet")
+			quiet = true;
+	}
+
+	std::shared_ptr<TranspositionTable> table;
+
+	if (!options.create_table(table))
+		return 1;
+
+	ReplayAnalyzer analyzer(arguments[1]);
+
+	if (!analyzer.is_open())
+	{
+		std::cout << "ERROR:    Cannot read transcript " << arguments[1] << std::endl;
+		return 1;
+	}
+
+	if (table)
+		analyzer.set_transposition_table(table);
+
+	auto start = std::chrono::steady_clock::now();
+	auto result = analyzer.run(options.threads);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	Board board(PLAYER_RED, false);
+	const auto & games = analyzer.get_games();
+
+	for (size_t game = 0; game < games.size(); game++)
+	{
+		const ReplayGame & record = games[game];
+
+		if (record.error_line > 0)
+			std::cout << "WARNING:  Line " << record.error_line << ": Invalid command in game " << game + 1 << std::endl;
+
+		if (quiet)
+			continue;
+
+		int loss = 0;
+
+		for (size_t ply = 0; ply < record.moves.size(); ply++)
+		{
+			const ReplayMove & move = record.moves[ply];
+			loss += move.best - move.played;
+
+			std::cout << std::left << "MOVE:     ";
+			std::cout << std::setw(6) << "Game:" << std::setw(8) << game + 1;
+			std::cout << std::setw(5) << "Ply:" << std::setw(4) << ply + 1;
+			std::cout << std::setw(5) << (move.player == PLAYER_RED ? "Red" : "Blue");
+			std::cout << "(" << move.row + 1 << ", " << move.column + 1 << ") " << std::setw(20) << board.get_cards()[move.card]->name;
+			std::cout << std::setw(6) << "Best:" << std::setw(5) << move.best;
+			std::cout << std::setw(8) << "Played:" << std::setw(5) << move.played;
+			std::cout << std::setw(6) << "Loss:" << move.best - move.played;
+			std::cout << std::endl;
+		}
+
+		std::cout << std::left << "GAME:     ";
+		std::cout << std::setw(6) << "Game:" << std::setw(8) << game + 1;
+		std::cout << std::setw(6) << "Line:" << std::setw(10) << record.line;
+		std::cout << std::setw(7) << "Moves:" << std::setw(4) << record.moves.size();
+		std::cout << std::setw(6) << "Loss:" << loss;
+		std::cout << std::endl;
+	}
+
+	std::cout << std::left << std::fixed << "REPLAY:   ";
+	std::cout << std::setw(7) << "Games:" << std::setw(10) << result.games;
+	std::cout << std::setw(9) << "Invalid:" << std::setw(8) << result.invalid;
+	std::cout << std::setw(7) << "Moves:" << std::setw(12) << result.moves;
+	std::cout << std::setw(10) << "Mistakes:" << std::setw(10) << result.mistakes;
+	std::cout << std::setw(6) << "Loss:" << std::setw(8) << std::setprecision(3) << static_cast<double>(result.loss) / std::max(1l, result.moves);
+	std::cout << std::setw(11) << "Positions:" << std::setw(14) << result.positions;
+	std::cout << std::setw(7) << "Parse:" << std::setw(9) << result.parse_seconds;
+	std::cout << std::setw(7) << "Solve:" << std::setw(9) << result.solve_seconds;
+	std::cout << std::setw(9) << "Seconds:" << std::setw(8) << seconds;
+	std::cout << std::endl;
+
+	return result.invalid == 0 ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_REPLAY_HH
+#define TRIPLETRIAD_REPLAY_HH
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "board.hh"
+
+/*
+ * A run of characters in a mapped transcript, used in place of a copied
+ * string while parsing.
+ */
+struct TranscriptSpan
+{
+	TranscriptSpan();
+	TranscriptSpan(const char * begin, const char * end);
+
+	bool empty() const;
+	bool operator==(const char * text) const;
+	bool matches(const std::string & name) const;
+
+	const char * begin;
+	const char * end;
+};
+
+struct ReplayMove
+{
+	Player player;
+
+	int row;
+	int column;
+	int card;
+
+	int best;
+	int played;
+};
+
+struct ReplayGame
+{
+	ReplayGame();
+
+	long line;
+	long error_line;
+
+	std::vector<ReplayMove> moves;
+};
+
+struct ReplayResult
+{
+	ReplayResult();
+
+	void merge(const ReplayResult & other);
+
+	long games;
+	long invalid;
+	long moves;
+	long mistakes;
+	long loss;
+	long positions;
+
+	double parse_seconds;
+	double solve_seconds;
+};
+
+/*
+ * Replays recorded games, written as the commands the interactive loop reads
+ * (new, element, card, position and play), and scores each move against the
+ * best move with an exact search. The transcript is mapped into memory and
+ * parsed in place. Each game begins at a new command, and the games are
+ * handed out to threads one at a time, each thread replaying on its own
+ * board; other commands are ignored.
+ */
+class ReplayAnalyzer
+{
+	public:
+		ReplayAnalyzer(const std::string & path);
+		~ReplayAnalyzer();
+
+		ReplayAnalyzer(const ReplayAnalyzer &) = delete;
+		ReplayAnalyzer & operator=(const ReplayAnalyzer &) = delete;
+
+		bool is_open() const;
+
+		void set_transposition_table(const std::shared_ptr<TranspositionTable> & table);
+
+		ReplayResult run(int threads);
+
+		const std::vector<ReplayGame> & get_games() const;
+
+	private:
+		static const size_t GENERATION_GAMES = 16;
+
+		void _run_thread(std::atomic<size_t> & next, ReplayResult & result);
+		bool _replay(Board & board, size_t game, ReplayResult & result);
+		int _solve(Board & board, ReplayResult & result);
+
+		bool _open;
+
+		const char * _data;
+		size_t _size;
+
+		std::vector<const char *> _starts;
+		std::vector<ReplayGame> _games;
+
+		std::shared_ptr<TranspositionTable> _transposition_table;
+};
+
+int replay_main(const std::vector<std::string> & arguments);
+
+#endif
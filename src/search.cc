@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include "search.hh"
+
+SearchProgress::SearchProgress() :
+	positions(0),
+	searched_moves(0),
+	total_moves(0),
+	best_score(0),
+	complete(false),
+	cancelled(false)
+{ }
+
+SearchControl::SearchControl() :
+	_cancelled(false),
+	_positions(0),
+	_next_report(REPORT_INTERVAL)
+{ }
+
+SearchControl::SearchControl(const std::function<void(const SearchProgress &)> & callback) :
+	_cancelled(false),
+	_positions(0),
+	_callback(callback),
+	_next_report(REPORT_INTERVAL)
+{ }
+
+void SearchControl::cancel()
+{
+	_cancelled.store(true, std::memory_order_relaxed);
+}
+
+bool SearchControl::is_cancelled() const
+{
+	return _cancelled.load(std::memory_order_relaxed);
+}
+
+SearchProgress SearchControl::get_progress() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	SearchProgress progress(_progress);
+	progress.positions = std::max(progress.positions, _positions.load(std::memory_order_relaxed));
+	progress.cancelled = is_cancelled();
+
+	return progress;
+}
+
+/*
+ * Reports the latest root progress with the current position count, between
+ * root moves. Only the searching thread calls this.
+ */
+void SearchControl::_report_positions(int positions)
+{
+	SearchProgress progress;
+
+	_next_report = positions + REPORT_INTERVAL;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_progress.positions = positions;
+		progress = _progress;
+	}
+
+	_positions.store(positions, std::memory_order_relaxed);
+
+	if (_callback)
+		_callback(progress);
+}
+
+void SearchControl::report(const SearchProgress & progress)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_progress = progress;
+		_positions.store(progress.positions, std::memory_order_relaxed);
+	}
+
+	if (_callback)
+		_callback(progress);
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_SEARCH_HH
+#define TRIPLETRIAD_SEARCH_HH
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "move.hh"
+
+/*
+ * A snapshot of a running search. The best move and score cover the root moves
+ * searched so far, and the score is in the units of Board::find_move.
+ */
+struct SearchProgress
+{
+	SearchProgress();
+
+	long positions;
+
+	int searched_moves;
+	int total_moves;
+
+	std::shared_ptr<Move> best_move;
+	int best_score;
+
+	bool complete;
+	bool cancelled;
+};
+
+/*
+ * Links an asynchronous search to its owner, and is used for one search only.
+ * The owner may cancel the search from any thread; the search checks for this
+ * at every node and unwinds, leaving the board as it was. Progress is reported
+ * after each root move and every REPORT_INTERVAL positions, to the callback if
+ * one is given, which runs on the searching thread.
+ */
+class SearchControl
+{
+	public:
+		SearchControl();
+		explicit SearchControl(const std::function<void(const SearchProgress &)> & callback);
+
+		void cancel();
+		bool is_cancelled() const;
+
+		SearchProgress get_progress() const;
+
+		bool poll(int positions);
+		void report(const SearchProgress & progress);
+
+		static const int REPORT_INTERVAL = 1 << 20;
+
+	private:
+		void _report_positions(int positions);
+
+		std::atomic<bool> _cancelled;
+		std::atomic<long> _positions;
+
+		std::function<void(const SearchProgress &)> _callback;
+
+		mutable std::mutex _mutex;
+		SearchProgress _progress;
+
+		int _next_report;
+};
+
+/*
+ * Called at every node: publishes the position count now and then, reports
+ * progress once past the next interval, and tells the search whether to stop.
+ */
+inline bool SearchControl::poll(int positions)
+{
+	if ((positions & 0x3ff) == 0)
+		_positions.store(positions, std::memory_order_relaxed);
+
+	if (positions >= _next_report)
+		_report_positions(positions);
+
+	return _cancelled.load(std::memory_order_relaxed);
+}
+
+#endif
@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "dealer.hh"
+#include "options.hh"
+#include "policy.hh"
+#include "selfplay.hh"
+
+SelfPlayResult::SelfPlayResult() :
+	games(0),
+	draws(0),
+	margin(0)
+{
+	wins[PLAYER_RED] = 0;
+	wins[PLAYER_BLUE] = 0;
+}
+
+void SelfPlayResult::merge(const SelfPlayResult & other)
+{
+	games += other.games;
+	wins[PLAYER_RED] += other.wins[PLAYER_RED];
+	wins[PLAYER_BLUE] += other.wins[PLAYER_BLUE];
+	draws += other.draws;
+	margin += other.margin;
+
+	card_games.resize(std::max(card_games.size(), other.card_games.size()));
+	card_wins.resize(std::max(card_wins.size(), other.card_wins.size()));
+
+	for (size_t i = 0; i < other.card_games.size(); i++)
+	{
+		card_games[i] += other.card_games[i];
+		card_wins[i] += other.card_wins[i];
+	}
+}
+
+SelfPlay::SelfPlay(const std::string & red_policy, const std::string & blue_policy, int minimum_level, int maximum_level, bool elemental, unsigned int seed) :
+	_minimum_level(minimum_level),
+	_maximum_level(maximum_level),
+	_elemental(elemental),
+	_seed(seed)
+{
+	_policies[PLAYER_RED] = red_policy;
+	_policies[PLAYER_BLUE] = blue_policy;
+}
+
+/*
+ * Makes every thread's board use the given table instead of its own.
+ */
+void SelfPlay::set_transposition_table(const std::shared_ptr<TranspositionTable> & table)
+{
+	_transposition_table = table;
+}
+
+/*
+ * Plays the given number of games, split evenly across threads. Each thread
+ * owns its board, policies and totals, so nothing is shared until the totals
+ * are merged at the end.
+ */
+SelfPlayResult SelfPlay::run(long games, int threads)
+{
+	std::vector<SelfPlayResult> results(threads);
+	std::vector<std::thread> workers;
+
+	for (int thread = 0; thread < threads; thread++)
+	{
+		long count = games / threads + (thread < games % threads ? 1 : 0);
+		workers.push_back(std::thread(&SelfPlay::_run_thread, this, thread, count, std::ref(results[thread])));
+	}
+
+	SelfPlayResult total;
+
+	for (int thread = 0; thread < threads; thread++)
+	{
+		workers[thread].join();
+		total.merge(results[thread]);
+	}
+
+	return total;
+}
+
+void SelfPlay::_run_thread(int thread, long games, SelfPlayResult & result)
+{
+	std::mt19937 random(_seed + thread);
+
+	Board board(PLAYER_RED, _elemental);
+	SelfPlayResult local;
+
+	if (_transposition_table)
+		board.set_transposition_table(_transposition_table);
+
+	Dealer dealer(board, _minimum_level, _maximum_level, _elemental);
+
+	std::shared_ptr<Policy> policies[2] = {Policy::create(_policies[PLAYER_RED]), Policy::create(_policies[PLAYER_BLUE])};
+	std::vector<std::shared_ptr<Card>> hands[2];
+
+	local.card_games.resize(board.get_cards().size());
+	local.card_wins.resize(board.get_cards().size());
+
+	for (long game = 0; game < games; game++)
+	{
+		/* A shared table ages once per round of games, a private one once per game. */
+		if (!_transposition_table || thread == 0)
+			board.get_transposition_table()->next_generation();
+
+		dealer.deal(board, random, hands);
+
+		while (!board.is_complete())
+			board.move(policies[board.get_current_player()]->choose(board, random), false);
+
+		int margin = board.get_score(PLAYER_RED) - board.get_score(PLAYER_BLUE);
+
+		local.games++;
+		local.margin += margin;
+
+		if (margin == 0)
+			local.draws++;
+		else
+			local.wins[margin > 0 ? PLAYER_RED : PLAYER_BLUE]++;
+
+		for (int player = PLAYER_RED; player <= PLAYER_BLUE; player++)
+		{
+			bool won = player == PLAYER_RED ? margin > 0 : margin < 0;
+
+			for (auto & card : hands[player])
+			{
+				local.card_games[card->index]++;
+
+				if (won)
+					local.card_wins[card->index]++;
+			}
+		}
+	}
+
+	result = local;
+}
+
+int selfplay_main(const std::vector<std::string> & arguments)
+{
+	long games = 100000;
+	bool elemental = false;
+	unsigned int seed = 1;
+
+	BatchOptions options;
+
+	std::string policies[2] = {"greedy", "greedy"};
+
+	for (size_t i = 1; i < arguments.size(); i++)
+	{
+		if (options.parse(arguments, i))
+			continue;
+
+		if (arguments[i] == "elemental")
+			elemental = true;
+		else if (i + 1 >= arguments.size())
+			break;
+		else if (arguments[i] == "games")
+			games = std::atol(arguments[++i].c_str());
+		else if (arguments[i] == "red")
+			policies[PLAYER_RED] = arguments[++i];
+		else if (arguments[i] == "blue")
+			policies[PLAYER_BLUE] = arguments[++i];
+		else if (arguments[i] == "seed")
+			seed = std::atoi(arguments[++i].c_str());
+	}
+
+	if (!options.check())
+		return 1;
+
+	for (auto & policy : policies)
+	{
+		if (!Policy::create(policy))
+		{
+			std::cout << "ERROR:    Invalid policy: " << policy << std::endl;
+			return 1;
+		}
+	}
+
+	std::shared_ptr<TranspositionTable> table;
+
+	if (!options.create_table(table))
+		return 1;
+
+	SelfPlay selfplay(policies[PLAYER_RED], policies[PLAYER_BLUE], options.minimum_level, options.maximum_level, elemental, seed);
+
+	if (table)
+		selfplay.set_transposition_table(table);
+
+	auto start = std::chrono::steady_clock::now();
+	auto result = selfplay.run(games, options.threads);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << std::left << std::fixed << "SELFPLAY: ";
+	std::cout << std::setw(7) << "Games:" << std::setw(12) << result.games;
+	std::cout << std::setw(5) << "Red:" << std::setw(10) << result.wins[PLAYER_RED];
+	std::cout << std::setw(6) << "Blue:" << std::setw(10) << result.wins[PLAYER_BLUE];
+	std::cout << std::setw(6) << "Draw:" << std::setw(10) << result.draws;
+	std::cout << std::setw(8) << "Margin:" << std::setw(10) << std::setprecision(3) << static_cast<double>(result.margin) / std::max(1l, result.games);
+	std::cout << std::setw(10) << "Games/h:" << std::setw(12) << std::setprecision(0) << result.games / seconds * 3600;
+	std::cout << std::endl;
+
+	Board board(PLAYER_RED, false);
+
+	for (auto & card : board.get_cards())
+	{
+		if (result.card_games[card->index] == 0)
+			continue;
+
+		std::cout << std::left << "CARD:     ";
+		std::cout << std::setw(20) << card->name;
+		std::cout << std::setw(7) << "Games:" << std::setw(12) << result.card_games[card->index];
+		std::cout << std::setw(10) << "Win rate:" << std::setw(10) << std::setprecision(3) << static_cast<double>(result.card_wins[card->index]) / result.card_games[card->index];
+		std::cout << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_SELFPLAY_HH
+#define TRIPLETRIAD_SELFPLAY_HH
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "board.hh"
+
+/*
+ * Totals gathered by a single thread. Card statistics count each game in which
+ * a card was dealt once, from the perspective of the player holding it.
+ */
+struct SelfPlayResult
+{
+	SelfPlayResult();
+
+	void merge(const SelfPlayResult & other);
+
+	long games;
+	long wins[2];
+	long draws;
+	long margin;
+
+	std::vector<long> card_games;
+	std::vector<long> card_wins;
+};
+
+class SelfPlay
+{
+	public:
+		SelfPlay(const std::string & red_policy, const std::string & blue_policy, int minimum_level, int maximum_level, bool elemental, unsigned int seed);
+
+		void set_transposition_table(const std::shared_ptr<TranspositionTable> & table);
+
+		SelfPlayResult run(long games, int threads);
+
+	private:
+		void _run_thread(int thread, long games, SelfPlayResult & result);
+
+		std::string _policies[2];
+
+		int _minimum_level;
+		int _maximum_level;
+
+		bool _elemental;
+
+		unsigned int _seed;
+
+		std::shared_ptr<TranspositionTable> _transposition_table;
+};
+
+int selfplay_main(const std::vector<std::string> & arguments);
+
+#endif
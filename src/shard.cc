@@ -0,0 +1,715 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "dealer.hh"
+#include "position.hh"
+#include "shard.hh"
+
+template <int Rows, int Columns>
+BasicShardedSolver<Rows, Columns>::BasicShardedSolver(const BasicBoard<Rows, Columns> & board, int workers, int plies, double timeout, double crash_rate, double hang_rate, unsigned int seed) :
+	_board(board),
+	_root(board.snapshot()),
+	_self(board.get_current_player()),
+	_plies(plies),
+	_timeout(timeout),
+	_crash_rate(crash_rate),
+	_hang_rate(hang_rate),
+	_seed(seed),
+	_workers(workers),
+	_units(0),
+	_searches(0),
+	_crashes(0),
+	_timeouts(0),
+	_positions(0),
+	_started_workers(0)
+{
+	for (auto & worker : _workers)
+	{
+		worker.pid = -1;
+		worker.socket = -1;
+		worker.unit = -1;
+	}
+}
+
+template <int Rows, int Columns>
+BasicShardedSolver<Rows, Columns>::~BasicShardedSolver()
+{
+	for (auto & worker : _workers)
+		_stop_worker(worker);
+}
+
+/*
+ * Solves the position, returning false if the workers cannot be started.
+ */
+template <int Rows, int Columns>
+bool BasicShardedSolver<Rows, Columns>::run()
+{
+	_expand();
+
+	std::signal(SIGPIPE, SIG_IGN);
+	std::fflush(stdout);
+
+	for (auto & worker : _workers)
+	{
+		if (!_start_worker(worker, _started_workers++))
+			return false;
+	}
+
+	while (_nodes[0].lower < _nodes[0].upper)
+	{
+		for (auto & worker : _workers)
+		{
+			if (worker.unit >= 0)
+				continue;
+
+			int alpha, beta;
+			int unit = _find_unit(0, -_board.get_score_bound(), _board.get_score_bound(), alpha, beta);
+
+			if (unit < 0)
+				break;
+
+			worker.alpha = alpha;
+			worker.beta = beta;
+
+			if (!_send(worker, unit))
+			{
+				_crashes++;
+
+				if (!_replace_worker(worker))
+					return false;
+			}
+		}
+
+		std::vector<pollfd> descriptors;
+		std::vector<Worker *> busy;
+
+		auto now = std::chrono::steady_clock::now();
+		auto deadline = now + std::chrono::hours(24);
+
+		for (auto & worker : _workers)
+		{
+			if (worker.unit >= 0)
+			{
+				descriptors.push_back({worker.socket, POLLIN, 0});
+				busy.push_back(&worker);
+
+				deadline = std::min(deadline, worker.deadline);
+			}
+		}
+
+		if (descriptors.empty())
+			break;
+
+		int timeout = std::max(0, static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count()) + 1);
+
+		if (poll(descriptors.data(), descriptors.size(), timeout) < 0 && errno != EINTR)
+			return false;
+
+		for (size_t i = 0; i < descriptors.size(); i++)
+		{
+			Worker & worker = *busy[i];
+
+			if (descriptors[i].revents != 0 && !_receive(worker))
+			{
+				_crashes++;
+
+				if (!_replace_worker(worker))
+					return false;
+			}
+			else if (worker.unit >= 0 && std::chrono::steady_clock::now() >= worker.deadline)
+			{
+				_timeouts++;
+				_nodes[worker.unit].timeout *= 2;
+
+				if (!_replace_worker(worker))
+					return false;
+			}
+		}
+	}
+
+	for (auto & worker : _workers)
+		_stop_worker(worker);
+
+	return _nodes[0].lower == _nodes[0].upper;
+}
+
+template <int Rows, int Columns>
+int BasicShardedSolver<Rows, Columns>::get_score() const
+{
+	return _nodes[0].lower;
+}
+
+template <int Rows, int Columns>
+std::shared_ptr<Move> BasicShardedSolver<Rows, Columns>::get_move() const
+{
+	for (auto child : _nodes[0].children)
+	{
+		if (_nodes[child].lower >= _nodes[0].lower)
+			return _nodes[child].move;
+	}
+
+	return nullptr;
+}
+
+template <int Rows, int Columns>
+long BasicShardedSolver<Rows, Columns>::get_units() const
+{
+	return _units;
+}
+
+template <int Rows, int Columns>
+long BasicShardedSolver<Rows, Columns>::get_searches() const
+{
+	return _searches;
+}
+
+template <int Rows, int Columns>
+long BasicShardedSolver<Rows, Columns>::get_crashes() const
+{
+	return _crashes;
+}
+
+template <int Rows, int Columns>
+long BasicShardedSolver<Rows, Columns>::get_timeouts() const
+{
+	return _timeouts;
+}
+
+template <int Rows, int Columns>
+long BasicShardedSolver<Rows, Columns>::get_positions() const
+{
+	return _positions;
+}
+
+/*
+ * Builds the tree down to the unit depth, replaying each node's moves from
+ * the root position.
+ */
+template <int Rows, int Columns>
+void BasicShardedSolver<Rows, Columns>::_expand()
+{
+	Node root;
+	root.parent = -1;
+	root.maximizing = true;
+	root.searching = false;
+	root.lower = -_board.get_score_bound();
+	root.upper = _board.get_score_bound();
+	root.timeout = _timeout;
+
+	_nodes.push_back(root);
+
+	for (size_t node = 0; node < _nodes.size(); node++)
+	{
+		auto path = _get_path(node);
+
+		if (static_cast<int>(path.size()) >= _plies)
+		{
+			_units++;
+			continue;
+		}
+
+		_board.restore(_root);
+
+		for (auto & move : path)
+			_board.move(move, false);
+
+		auto moves = _board.get_moves();
+
+		if (moves.empty())
+		{
+			_units++;
+			continue;
+		}
+
+		bool maximizing = _board.get_current_player() == _self;
+
+		for (auto & move : moves)
+		{
+			Node child(root);
+			child.parent = node;
+			child.move = move;
+			child.maximizing = !maximizing;
+
+			_nodes[node].children.push_back(_nodes.size());
+			_nodes.push_back(child);
+		}
+	}
+}
+
+/*
+ * Recomputes the bounds of a node's ancestors after its own have changed.
+ */
+template <int Rows, int Columns>
+void BasicShardedSolver<Rows, Columns>::_update(int node)
+{
+	for (node = _nodes[node].parent; node >= 0; node = _nodes[node].parent)
+	{
+		Node & parent = _nodes[node];
+
+		parent.lower = parent.maximizing ? -_board.get_score_bound() : _board.get_score_bound();
+		parent.upper = parent.lower;
+
+		for (auto child : parent.children)
+		{
+			if (parent.maximizing)
+			{
+				parent.lower = std::max(parent.lower, _nodes[child].lower);
+				parent.upper = std::max(parent.upper, _nodes[child].upper);
+			}
+			else
+			{
+				parent.lower = std::min(parent.lower, _nodes[child].lower);
+				parent.upper = std::min(parent.upper, _nodes[child].upper);
+			}
+		}
+	}
+}
+
+/*
+ * Finds the first unit, in move order, that is not being searched and could
+ * still change the root's bounds, along with the window to search it with.
+ * Each child's window is narrowed by the best bound among its siblings.
+ */
+template <int Rows, int Columns>
+int BasicShardedSolver<Rows, Columns>::_find_unit(int node, int alpha, int beta, int & unit_alpha, int & unit_beta) const
+{
+	const Node & current = _nodes[node];
+
+	alpha = std::max(alpha, current.lower);
+	beta = std::min(beta, current.upper);
+
+	if (alpha >= beta)
+		return -1;
+
+	if (current.children.empty())
+	{
+		unit_alpha = alpha;
+		unit_beta = beta;
+
+		return current.searching ? -1 : node;
+	}
+
+	int first = -_board.get_score_bound();
+	int second = first;
+
+	for (auto child : current.children)
+	{
+		int bound = current.maximizing ? _nodes[child].lower : -_nodes[child].upper;
+
+		if (bound > first)
+		{
+			second = first;
+			first = bound;
+		}
+		else if (bound > second)
+		{
+			second = bound;
+		}
+	}
+
+	for (auto child : current.children)
+	{
+		int bound = current.maximizing ? _nodes[child].lower : -_nodes[child].upper;
+		int sibling = bound == first ? second : first;
+
+		int unit = current.maximizing ? _find_unit(child, std::max(alpha, sibling), beta, unit_alpha, unit_beta) : _find_unit(child, alpha, std::min(beta, -sibling), unit_alpha, unit_beta);
+
+		if (unit >= 0)
+			return unit;
+	}
+
+	return -1;
+}
+
+template <int Rows, int Columns>
+bool BasicShardedSolver<Rows, Columns>::_start_worker(Worker & worker, int number)
+{
+	int sockets[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+		return false;
+
+	pid_t pid = fork();
+
+	if (pid < 0)
+	{
+		close(sockets[0]);
+		close(sockets[1]);
+
+		return false;
+	}
+
+	if (pid == 0)
+	{
+		close(sockets[0]);
+
+		for (auto & other : _workers)
+		{
+			if (other.socket >= 0)
+				close(other.socket);
+		}
+
+		_run_worker(sockets[1], number);
+	}
+
+	close(sockets[1]);
+
+	worker.pid = pid;
+	worker.socket = sockets[0];
+	worker.buffer.clear();
+	worker.unit = -1;
+
+	return true;
+}
+
+template <int Rows, int Columns>
+void BasicShardedSolver<Rows, Columns>::_stop_worker(Worker & worker)
+{
+	if (worker.unit >= 0)
+		_nodes[worker.unit].searching = false;
+
+	if (worker.socket >= 0)
+		close(worker.socket);
+
+	/* An idle worker would exit on its own, but a hung one never does. */
+	if (worker.pid > 0)
+	{
+		kill(worker.pid, SIGKILL);
+		waitpid(worker.pid, nullptr, 0);
+	}
+
+	worker.pid = -1;
+	worker.socket = -1;
+	worker.unit = -1;
+}
+
+/*
+ * Stops a worker that failed, releasing its unit to be sent again, and starts
+ * a new one in its place.
+ */
+template <int Rows, int Columns>
+bool BasicShardedSolver<Rows, Columns>::_replace_worker(Worker & worker)
+{
+	_stop_worker(worker);
+
+	return _start_worker(worker, _started_workers++);
+}
+
+/*
+ * The worker's side: solves units until the coordinator closes the socket. A
+ * nonzero crash or hang rate makes workers exit, or stop forever, without
+ * replying to that fraction of units, to exercise recovery.
+ */
+template <int Rows, int Columns>
+void BasicShardedSolver<Rows, Columns>::_run_worker(int socket, int number)
+{
+	std::mt19937 random(_seed + number);
+	std::uniform_real_distribution<double> fault_distribution(0.0, 1.0);
+
+	std::FILE * input = fdopen(socket, "r");
+	char line[256];
+
+	while (input && std::fgets(line, sizeof(line), input))
+	{
+		std::istringstream request(line);
+		std::string command;
+		int unit, alpha, beta, count;
+
+		if (!(request >> command >> unit >> alpha >> beta >> count) || command != "UNIT")
+			break;
+
+		_board.restore(_root);
+
+		for (int i = 0; i < count; i++)
+		{
+			int square, card;
+			request >> square >> card;
+
+			_board.move(_board.get_move(square / _board.get_columns(), square % _board.get_columns(), _board.get_cards()[card]->name), false);
+		}
+
+		if (_crash_rate > 0.0 && fault_distribution(random) < _crash_rate)
+			_exit(1);
+
+		if (_hang_rate > 0.0 && fault_distribution(random) < _hang_rate)
+		{
+			for (;;)
+				pause();
+		}
+
+		int positions = 0;
+		int score = _board.search(_self, alpha, beta, positions);
+
+		char reply[64];
+		int length = std::snprintf(reply, sizeof(reply), "RESULT %d %d %d\n", unit, score, positions);
+
+		if (write(socket, reply, length) != length)
+			break;
+	}
+
+	_exit(0);
+}
+
+template <int Rows, int Columns>
+bool BasicShardedSolver<Rows, Columns>::_send(Worker & worker, int unit)
+{
+	std::ostringstream request;
+	auto path = _get_path(unit);
+
+	request << "UNIT " << unit << " " << worker.alpha << " " << worker.beta << " " << path.size();
+
+	for (auto & move : path)
+		request << " " << move->square->index << " " << move->card->index;
+
+	request << "\n";
+
+	std::string text = request.str();
+
+	worker.unit = unit;
+	worker.deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(_nodes[unit].timeout));
+	_nodes[unit].searching = true;
+	_searches++;
+
+	for (size_t written = 0; written < text.size(); )
+	{
+		ssize_t result = write(worker.socket, text.data() + written, text.size() - written);
+
+		if (result <= 0)
+			return false;
+
+		written += result;
+	}
+
+	return true;
+}
+
+/*
+ * Reads whatever the worker has sent and applies any complete result. Returns
+ * false if the worker has gone away.
+ */
+template <int Rows, int Columns>
+bool BasicShardedSolver<Rows, Columns>::_receive(Worker & worker)
+{
+	char data[256];
+	ssize_t size = read(worker.socket, data, sizeof(data));
+
+	if (size <= 0)
+		return false;
+
+	worker.buffer.append(data, size);
+
+	for (size_t end = worker.buffer.find('\n'); end != std::string::npos; end = worker.buffer.find('\n'))
+	{
+		std::istringstream reply(worker.buffer.substr(0, end));
+		std::string command;
+		int unit, score;
+		long positions;
+
+		worker.buffer.erase(0, end + 1);
+
+		if (!(reply >> command >> unit >> score >> positions) || command != "RESULT" || unit != worker.unit)
+			return false;
+
+		Node & node = _nodes[unit];
+
+		if (score <= worker.alpha)
+			node.upper = std::min(node.upper, score);
+		else if (score >= worker.beta)
+			node.lower = std::max(node.lower, score);
+		else
+			node.lower = node.upper = score;
+
+		node.searching = false;
+		worker.unit = -1;
+
+		_positions += positions;
+		_update(unit);
+	}
+
+	return true;
+}
+
+template <int Rows, int Columns>
+std::vector<std::shared_ptr<Move>> BasicShardedSolver<Rows, Columns>::_get_path(int node) const
+{
+	std::vector<std::shared_ptr<Move>> path;
+
+	for (; node > 0; node = _nodes[node].parent)
+		path.push_back(_nodes[node].move);
+
+	std::reverse(path.begin(), path.end());
+
+	return path;
+}
+
+/*
+ * Deals a game from the seed and plays random moves until the given number of
+ * squares is empty.
+ */
+template <int Rows, int Columns>
+static void _deal(BasicBoard<Rows, Columns> & board, int empty, unsigned int seed)
+{
+	BasicDealer<Rows, Columns> dealer(board, 1, 10, false);
+	std::mt19937 random(seed);
+	std::vector<std::shared_ptr<Card>> hands[2];
+
+	dealer.deal(board, random, hands);
+
+	while (board.get_empty_count() > empty)
+	{
+		auto moves = board.get_moves();
+		board.move(moves[std::uniform_int_distribution<size_t>(0, moves.size() - 1)(random)], false);
+	}
+}
+
+template <int Rows, int Columns>
+static int _solve(const BasicBoard<Rows, Columns> & board, const std::string & name, int workers, int plies, double timeout, double crash_rate, double hang_rate, unsigned int seed)
+{
+	BasicShardedSolver<Rows, Columns> solver(board, workers, plies, timeout, crash_rate, hang_rate, seed);
+
+	auto start = std::chrono::steady_clock::now();
+
+	if (!solver.run())
+	{
+		std::cout << "ERROR:    Cannot solve " << name << std::endl;
+		return 1;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << std::left << std::fixed << "SHARD:    ";
+	std::cout << std::setw(7) << "Score:" << std::setw(6) << solver.get_score();
+
+	if (solver.get_move())
+		std::cout << std::setw(6) << "Move:" << std::setw(30) << *solver.get_move();
+
+	std::cout << std::setw(7) << "Units:" << std::setw(8) << solver.get_units();
+	std::cout << std::setw(10) << "Searches:" << std::setw(8) << solver.get_searches();
+	std::cout << std::setw(9) << "Crashes:" << std::setw(6) << solver.get_crashes();
+	std::cout << std::setw(10) << "Timeouts:" << std::setw(6) << solver.get_timeouts();
+	std::cout << std::setw(11) << "Positions:" << std::setw(12) << solver.get_positions();
+	std::cout << std::setw(9) << "Seconds:" << std::setw(8) << std::setprecision(2) << seconds;
+	std::cout << std::endl;
+
+	return 0;
+}
+
+/*
+ * Solves either an encoded 3x3 position given as the first argument, or,
+ * with "size N", a position on an NxN board dealt from the seed and played
+ * randomly until "empty" squares are left. Units get "timeout" seconds at
+ * first (default 60).
+ */
+int shard_main(const std::vector<std::string> & arguments)
+{
+	Position position;
+	bool encoded = arguments.size() >= 2 && Position::parse(arguments[1], position);
+
+	int workers = std::max(1u, std::thread::hardware_concurrency());
+	int plies = 2;
+	double timeout = 60.0;
+	double crash_rate = 0.0;
+	double hang_rate = 0.0;
+	unsigned int seed = 1;
+	int size = 0;
+	int empty = 9;
+
+	for (size_t i = encoded ? 2 : 1; i + 1 < arguments.size(); i++)
+	{
+		if (arguments[i] == "workers")
+			workers = std::max(1, std::atoi(arguments[++i].c_str()));
+		else if (arguments[i] == "plies")
+			plies = std::max(1, std::min(3, std::atoi(arguments[++i].c_str())));
+		else if (arguments[i] == "timeout")
+			timeout = std::max(0.001, std::atof(arguments[++i].c_str()));
+		else if (arguments[i] == "crash")
+			crash_rate = std::atof(arguments[++i].c_str());
+		else if (arguments[i] == "hang")
+			hang_rate = std::atof(arguments[++i].c_str());
+		else if (arguments[i] == "seed")
+			seed = std::atoi(arguments[++i].c_str());
+		else if (arguments[i] == "size")
+			size = std::atoi(arguments[++i].c_str());
+		else if (arguments[i] == "empty")
+			empty = std::max(1, std::atoi(arguments[++i].c_str()));
+	}
+
+	if (encoded)
+	{
+		Board board(PLAYER_RED, false);
+
+		if (!board.decode(position))
+		{
+			std::cout << "ERROR:    Cannot solve " << arguments[1] << std::endl;
+			return 1;
+		}
+
+		return _solve(board, arguments[1], workers, plies, timeout, crash_rate, hang_rate, seed);
+	}
+	else if (size == 3)
+	{
+		BasicBoard<3, 3> board(PLAYER_RED, false);
+		_deal(board, empty, seed);
+
+		return _solve(board, "the dealt position", workers, plies, timeout, crash_rate, hang_rate, seed);
+	}
+	else if (size == 4)
+	{
+		BasicBoard<4, 4> board(PLAYER_RED, false);
+		_deal(board, empty, seed);
+
+		return _solve(board, "the dealt position", workers, plies, timeout, crash_rate, hang_rate, seed);
+	}
+	else if (size == 5)
+	{
+		BasicBoard<5, 5> board(PLAYER_RED, false);
+		_deal(board, empty, seed);
+
+		return _solve(board, "the dealt position", workers, plies, timeout, crash_rate, hang_rate, seed);
+	}
+	else
+	{
+		std::cout << "ERROR:    No valid position or board size (3, 4 or 5) given" << std::endl;
+		return 1;
+	}
+}
+
+template class BasicShardedSolver<3, 3>;
+template class BasicShardedSolver<4, 4>;
+template class BasicShardedSolver<5, 5>;
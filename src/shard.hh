@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_SHARD_HH
+#define TRIPLETRIAD_SHARD_HH
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "board.hh"
+#include "move.hh"
+
+/*
+ * Solves the position on a board with a pool of worker processes, each with its own board
+ * and transposition table. The game tree is expanded to a fixed number of
+ * plies, and every position at that depth is a work unit that a worker
+ * searches to the end of the game.
+ *
+ * The coordinator keeps bounds on every node of the expanded tree. A unit is
+ * sent with the alpha-beta window implied by the bounds of its ancestors'
+ * other children, and sent again with a narrower window if a fail-hard result
+ * leaves the root undecided. Units that are no longer needed are never sent.
+ *
+ * Workers talk to the coordinator over a socket pair, one line per message:
+ *
+ *   UNIT id alpha beta count square card ...
+ *   RESULT id score positions
+ *
+ * Squares are numbered in row-major order and cards by their catalog index,
+ * so the messages are the same for every board size. A worker that exits or
+ * closes its socket before replying is replaced, and its unit is sent again.
+ * So is a worker that has not replied by the unit's deadline, which is killed;
+ * the unit's time limit then doubles, so a unit that is merely slow still gets
+ * solved eventually.
+ */
+template <int Rows, int Columns>
+class BasicShardedSolver
+{
+	public:
+		BasicShardedSolver(const BasicBoard<Rows, Columns> & board, int workers, int plies, double timeout, double crash_rate, double hang_rate, unsigned int seed);
+		~BasicShardedSolver();
+
+		bool run();
+
+		int get_score() const;
+		std::shared_ptr<Move> get_move() const;
+
+		long get_units() const;
+		long get_searches() const;
+		long get_crashes() const;
+		long get_timeouts() const;
+		long get_positions() const;
+
+	private:
+		struct Node
+		{
+			int parent;
+			std::vector<int> children;
+
+			std::shared_ptr<Move> move;
+
+			bool maximizing;
+			bool searching;
+
+			int lower;
+			int upper;
+
+			double timeout;
+		};
+
+		struct Worker
+		{
+			pid_t pid;
+			int socket;
+
+			std::string buffer;
+
+			int unit;
+			int alpha;
+			int beta;
+
+			std::chrono::steady_clock::time_point deadline;
+		};
+
+		void _expand();
+		void _update(int node);
+
+		int _find_unit(int node, int alpha, int beta, int & unit_alpha, int & unit_beta) const;
+
+		bool _start_worker(Worker & worker, int number);
+		void _stop_worker(Worker & worker);
+		void _run_worker(int socket, int number);
+		bool _replace_worker(Worker & worker);
+
+		bool _send(Worker & worker, int unit);
+		bool _receive(Worker & worker);
+
+		std::vector<std::shared_ptr<Move>> _get_path(int node) const;
+
+		BasicBoard<Rows, Columns> _board;
+		typename BasicBoard<Rows, Columns>::Snapshot _root;
+		Player _self;
+
+		int _plies;
+		double _timeout;
+		double _crash_rate;
+		double _hang_rate;
+		unsigned int _seed;
+
+		std::vector<Node> _nodes;
+		std::vector<Worker> _workers;
+
+		long _units;
+		long _searches;
+		long _crashes;
+		long _timeouts;
+		long _positions;
+
+		int _started_workers;
+};
+
+typedef BasicShardedSolver<3, 3> ShardedSolver;
+
+int shard_main(const std::vector<std::string> & arguments);
+
+#endif
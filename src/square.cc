@@ -24,9 +24,10 @@
 
 #include "square.hh"
 
-Square::Square(int row, int column) :
+Square::Square(int row, int column, int index) :
 	row(row),
 	column(column),
+	index(index),
 	element(ELEMENT_NONE),
 	_neighbors(4)
 { }
@@ -42,7 +43,7 @@ std::vector<std::shared_ptr<Square>> Square::create_squares(int rows, int column
 
 	for (int row = 0; row < rows; row++)
 		for (int column = 0; column < columns; column++)
-			squares[row * columns + column] = std::make_shared<Square>(row, column);
+			squares[row * columns + column] = std::make_shared<Square>(row, column, row * columns + column);
 
 	for (int row = 0; row < rows; row++)
 	{
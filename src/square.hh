@@ -35,7 +35,7 @@ class Move;
 class Square
 {
 	public:
-		Square(int row, int column);
+		Square(int row, int column, int index);
 
 		std::shared_ptr<Square> get_neighbor(Direction direction) const;
 
@@ -45,6 +45,7 @@ class Square
 
 		const int row;
 		const int column;
+		const int index;
 
 		Element element;
 
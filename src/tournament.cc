@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include "dealer.hh"
+#include "options.hh"
+#include "policy.hh"
+#include "tournament.hh"
+
+TournamentResult::TournamentResult() :
+	pairs(0),
+	wins(0),
+	draws(0),
+	losses(0),
+	pair_scores(0.0),
+	pair_squares(0.0)
+{
+	moves[0] = 0;
+	moves[1] = 0;
+	seconds[0] = 0.0;
+	seconds[1] = 0.0;
+}
+
+void TournamentResult::merge(const TournamentResult & other)
+{
+	pairs += other.pairs;
+	wins += other.wins;
+	draws += other.draws;
+	losses += other.losses;
+	pair_scores += other.pair_scores;
+	pair_squares += other.pair_squares;
+
+	for (int engine = 0; engine < 2; engine++)
+	{
+		moves[engine] += other.moves[engine];
+		seconds[engine] += other.seconds[engine];
+	}
+}
+
+/*
+ * Returns the first engine's share of the points.
+ */
+double TournamentResult::get_score() const
+{
+	return pairs > 0 ? pair_scores / pairs / 2 : 0.5;
+}
+
+/*
+ * Returns the standard error of the score, estimated from the variance of the
+ * pair scores.
+ */
+double TournamentResult::get_error() const
+{
+	if (pairs < 2)
+		return 0.5;
+
+	double mean = pair_scores / pairs;
+	double variance = (pair_squares / pairs - mean * mean) * pairs / (pairs - 1);
+
+	return std::sqrt(std::max(0.0, variance) / pairs) / 2;
+}
+
+Tournament::Tournament(const std::string & first_engine, const std::string & second_engine, int minimum_level, int maximum_level, bool elemental, unsigned int seed, int size) :
+	_minimum_level(minimum_level),
+	_maximum_level(maximum_level),
+	_elemental(elemental),
+	_seed(seed),
+	_size(size)
+{
+	_engines[0] = first_engine;
+	_engines[1] = second_engine;
+}
+
+/*
+ * Makes every thread's board use the given table instead of its own.
+ */
+void Tournament::set_transposition_table(const std::shared_ptr<TranspositionTable> & table)
+{
+	_transposition_table = table;
+}
+
+/*
+ * Plays the pairs numbered from first_pair, interleaved across threads.
+ */
+TournamentResult Tournament::run(long first_pair, long pairs, int threads)
+{
+	std::vector<TournamentResult> results(threads);
+	std::vector<std::thread> workers;
+
+	for (int thread = 0; thread < threads; thread++)
+		workers.push_back(std::thread(&Tournament::_run_thread, this, first_pair, pairs, threads, thread, std::ref(results[thread])));
+
+	TournamentResult total;
+
+	for (int thread = 0; thread < threads; thread++)
+	{
+		workers[thread].join();
+		total.merge(results[thread]);
+	}
+
+	return total;
+}
+
+void Tournament::_run_thread(long first_pair, long pairs, int threads, int thread, TournamentResult & result)
+{
+	if (_size == 5)
+		_play<5, 5>(first_pair, pairs, threads, thread, result);
+	else if (_size == 4)
+		_play<4, 4>(first_pair, pairs, threads, thread, result);
+	else
+		_play<3, 3>(first_pair, pairs, threads, thread, result);
+}
+
+template <int Rows, int Columns>
+void Tournament::_play(long first_pair, long pairs, int threads, int thread, TournamentResult & result)
+{
+	BasicBoard<Rows, Columns> board(PLAYER_RED, _elemental);
+	TournamentResult local;
+
+	if (_transposition_table)
+		board.set_transposition_table(_transposition_table);
+
+	BasicDealer<Rows, Columns> dealer(board, _minimum_level, _maximum_level, _elemental);
+
+	std::vector<std::shared_ptr<Card>> hands[2];
+
+	for (long pair = first_pair + thread; pair < first_pair + pairs; pair += threads)
+	{
+		double pair_score = 0.0;
+
+		/* A shared table ages once per round of pairs, a private one once per pair. */
+		if (!_transposition_table || thread == 0)
+			board.get_transposition_table()->next_generation();
+
+		for (int game = 0; game < 2; game++)
+		{
+			std::seed_seq deal_sequence{_seed, static_cast<unsigned int>(pair), static_cast<unsigned int>(pair >> 32)};
+			std::mt19937 deal_random(deal_sequence);
+
+			dealer.deal(board, deal_random, hands);
+
+			std::seed_seq sequence{_seed, static_cast<unsigned int>(pair), static_cast<unsigned int>(pair >> 32), static_cast<unsigned int>(game)};
+			std::mt19937 random(sequence);
+
+			Player first_engine_player = game == 0 ? PLAYER_RED : PLAYER_BLUE;
+			std::shared_ptr<BasicPolicy<Rows, Columns>> policies[2] = {BasicPolicy<Rows, Columns>::create(_engines[0]), BasicPolicy<Rows, Columns>::create(_engines[1])};
+
+			while (!board.is_complete())
+			{
+				int engine = board.get_current_player() == first_engine_player ? 0 : 1;
+
+				auto start = std::chrono::steady_clock::now();
+				auto move = policies[engine]->choose(board, random);
+				local.seconds[engine] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				local.moves[engine]++;
+
+				board.move(move, false);
+			}
+
+			int margin = board.get_score(first_engine_player) - board.get_score(first_engine_player == PLAYER_RED ? PLAYER_BLUE : PLAYER_RED);
+
+			if (margin > 0)
+			{
+				local.wins++;
+				pair_score += 1.0;
+			}
+			else if (margin == 0)
+			{
+				local.draws++;
+				pair_score += 0.5;
+			}
+			else
+			{
+				local.losses++;
+			}
+		}
+
+		local.pairs++;
+		local.pair_scores += pair_score;
+		local.pair_squares += pair_score * pair_score;
+	}
+
+	result = local;
+}
+
+/*
+ * Returns the point of the standard normal distribution with the given
+ * probability above it.
+ */
+static double _normal_quantile(double upper_tail)
+{
+	double low = 0.0;
+	double high = 40.0;
+
+	for (int i = 0; i < 100; i++)
+	{
+		double middle = (low + high) / 2;
+
+		if (0.5 * std::erfc(middle / std::sqrt(2.0)) > upper_tail)
+			low = middle;
+		else
+			high = middle;
+	}
+
+	return (low + high) / 2;
+}
+
+static std::string _format_interval(double lower, double upper)
+{
+	std::ostringstream stream;
+	stream << std::fixed << std::setprecision(3) << "(" << std::max(0.0, lower) << ", " << std::min(1.0, upper) << ")";
+
+	return stream.str();
+}
+
+static std::string _format_elo(double score)
+{
+	std::ostringstream stream;
+	stream << std::fixed << std::setprecision(0);
+
+	if (score <= 0.0)
+		stream << "-inf";
+	else if (score >= 1.0)
+		stream << "+inf";
+	else
+		stream << std::showpos << 0.0 - 400.0 * std::log10(1.0 / score - 1.0);
+
+	return stream.str();
+}
+
+/*
+ * Plays up to the given number of pairs in batches, and stops after any batch
+ * once the confidence interval on the first engine's score excludes an even
+ * result. The interval is widened for the number of batches that may be
+ * looked at (a Bonferroni correction), so stopping early keeps the chance of
+ * a false result within the requested confidence.
+ */
+int tournament_main(const std::vector<std::string> & arguments)
+{
+	long pairs = 10000;
+	long batch = 100;
+	bool elemental = false;
+	unsigned int seed = 1;
+	int size = 3;
+	double confidence = 0.95;
+
+	BatchOptions options;
+
+	std::string engines[2] = {"depth:3", "greedy"};
+
+	for (size_t i = 1; i < arguments.size(); i++)
+	{
+		if (options.parse(arguments, i))
+			continue;
+
+		if (arguments[i] == "elemental")
+			elemental = true;
+		else if (i + 1 >= arguments.size())
+			break;
+		else if (arguments[i] == "pairs")
+			pairs = std::max(1l, std::atol(arguments[++i].c_str()));
+		else if (arguments[i] == "batch")
+			batch = std::max(1l, std::atol(arguments[++i].c_str()));
+		else if (arguments[i] == "first")
+			engines[0] = arguments[++i];
+		else if (arguments[i] == "second")
+			engines[1] = arguments[++i];
+		else if (arguments[i] == "confidence")
+			confidence = std::max(0.5, std::min(0.999999, std::atof(arguments[++i].c_str())));
+		else if (arguments[i] == "seed")
+			seed = std::atoi(arguments[++i].c_str());
+		else if (arguments[i] == "size")
+			size = std::atoi(arguments[++i].c_str());
+	}
+
+	if (!options.check())
+		return 1;
+
+	if (size < 3 || size > 5)
+	{
+		std::cout << "ERROR:    Board size must be 3, 4 or 5" << std::endl;
+		return 1;
+	}
+
+	for (auto & engine : engines)
+	{
+		if (!Policy::create(engine))
+		{
+			std::cout << "ERROR:    Invalid engine: " << engine << std::endl;
+			return 1;
+		}
+	}
+
+	std::shared_ptr<TranspositionTable> table;
+
+	if (!options.create_table(table))
+		return 1;
+
+	Tournament tournament(engines[0], engines[1], options.minimum_level, options.maximum_level, elemental, seed, size);
+
+	if (table)
+		tournament.set_transposition_table(table);
+
+	long looks = (pairs + batch - 1) / batch;
+	double z = _normal_quantile((1.0 - confidence) / 2 / looks);
+
+	TournamentResult result;
+	bool significant = false;
+
+	auto start = std::chrono::steady_clock::now();
+
+	while (result.pairs < pairs && !significant)
+	{
+		result.merge(tournament.run(result.pairs, std::min(batch, pairs - result.pairs), options.threads));
+
+		double score = result.get_score();
+		double error = result.get_error();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		significant = result.pairs > 1 && std::abs(score - 0.5) > z * error;
+
+		std::cout << std::left << std::fixed << "MATCH:    ";
+		std::cout << std::setw(7) << "Pairs:" << std::setw(10) << result.pairs;
+		std::cout << std::setw(6) << "Wins:" << std::setw(9) << result.wins;
+		std::cout << std::setw(7) << "Draws:" << std::setw(9) << result.draws;
+		std::cout << std::setw(8) << "Losses:" << std::setw(9) << result.losses;
+		std::cout << std::setw(7) << "Score:" << std::setw(8) << std::setprecision(3) << score;
+		std::cout << std::setw(10) << "Interval:" << std::setw(16) << _format_interval(score - z * error, score + z * error);
+		std::cout << std::setw(5) << "Elo:" << std::setw(6) << _format_elo(score);
+		std::cout << std::setw(10) << "Seconds:" << std::setw(8) << std::setprecision(0) << seconds;
+		std::cout << std::endl;
+	}
+
+	for (int engine = 0; engine < 2; engine++)
+	{
+		std::cout << std::left << std::fixed << "ENGINE:   ";
+		std::cout << std::setw(20) << engines[engine];
+		std::cout << std::setw(7) << "Moves:" << std::setw(12) << result.moves[engine];
+		std::cout << std::setw(9) << "ms/move:" << std::setw(10) << std::setprecision(3) << 1000.0 * result.seconds[engine] / std::max(1l, result.moves[engine]);
+		std::cout << std::endl;
+	}
+
+	std::cout << "RESULT:   ";
+
+	if (!significant)
+		std::cout << "No significant difference";
+	else if (result.get_score() > 0.5)
+		std::cout << engines[0] << " is stronger";
+	else
+		std::cout << engines[1] << " is stronger";
+
+	std::cout << " at " << std::setprecision(1) << 100.0 * confidence << "% confidence" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_TOURNAMENT_HH
+#define TRIPLETRIAD_TOURNAMENT_HH
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "board.hh"
+
+/*
+ * Totals from the perspective of the first engine. Each pair of games scores
+ * one point per win and half a point per draw, so the pair scores are
+ * independent samples of the first engine's strength.
+ */
+struct TournamentResult
+{
+	TournamentResult();
+
+	void merge(const TournamentResult & other);
+
+	double get_score() const;
+	double get_error() const;
+
+	long pairs;
+	long wins;
+	long draws;
+	long losses;
+
+	double pair_scores;
+	double pair_squares;
+
+	long moves[2];
+	double seconds[2];
+};
+
+/*
+ * Plays two engines, given as policy names, against each other in pairs of
+ * games. Both games of a pair share a deal of hands, elements and first
+ * player, with the engines swapping sides, so the luck of the deal cancels
+ * out. Each pair is dealt from its own seed, so the deals do not depend on
+ * the number of threads. Games are played on square boards of 3, 4 or 5
+ * squares a side.
+ */
+class Tournament
+{
+	public:
+		Tournament(const std::string & first_engine, const std::string & second_engine, int minimum_level, int maximum_level, bool elemental, unsigned int seed, int size);
+
+		void set_transposition_table(const std::shared_ptr<TranspositionTable> & table);
+
+		TournamentResult run(long first_pair, long pairs, int threads);
+
+	private:
+		void _run_thread(long first_pair, long pairs, int threads, int thread, TournamentResult & result);
+
+		template <int Rows, int Columns>
+		void _play(long first_pair, long pairs, int threads, int thread, TournamentResult & result);
+
+		std::string _engines[2];
+
+		int _minimum_level;
+		int _maximum_level;
+
+		bool _elemental;
+
+		unsigned int _seed;
+		int _size;
+
+		std::shared_ptr<TranspositionTable> _transposition_table;
+};
+
+int tournament_main(const std::vector<std::string> & arguments);
+
+#endif
@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+#include "trace.hh"
+
+static const char FILE_MAGIC[8] = {'T', 'T', 'T', 'R', 'A', 'C', 'E', 0};
+static const uint32_t VERSION = 2;
+static const int FILE_HEADER_SIZE = 16;
+
+static void _put_u16(unsigned char * bytes, uint16_t value)
+{
+	bytes[0] = value;
+	bytes[1] = value >> 8;
+}
+
+static void _put_u32(unsigned char * bytes, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+		bytes[i] = value >> (8 * i);
+}
+
+static uint16_t _get_u16(const unsigned char * bytes)
+{
+	return bytes[0] | bytes[1] << 8;
+}
+
+static uint32_t _get_u32(const unsigned char * bytes)
+{
+	uint32_t value = 0;
+
+	for (int i = 0; i < 4; i++)
+		value |= static_cast<uint32_t>(bytes[i]) << (8 * i);
+
+	return value;
+}
+
+SearchTracer::SearchTracer(const std::string & path, int sample_rate, size_t buffer_records, bool ring) :
+	_file(std::fopen(path.c_str(), "wb")),
+	_sample_rate(sample_rate),
+	_ring(ring),
+	_buffer(std::max<size_t>(1, buffer_records)),
+	_count(0)
+{
+	unsigned char header[FILE_HEADER_SIZE];
+
+	std::memcpy(header, FILE_MAGIC, 8);
+	_put_u32(header + 8, VERSION);
+	_put_u32(header + 12, RECORD_SIZE);
+
+	if (_file && std::fwrite(header, FILE_HEADER_SIZE, 1, _file) != 1)
+	{
+		std::fclose(_file);
+		_file = nullptr;
+	}
+}
+
+SearchTracer::~SearchTracer()
+{
+	if (!_file)
+		return;
+
+	if (_ring && _count > _buffer.size())
+	{
+		_write(_count % _buffer.size(), _buffer.size());
+		_write(0, _count % _buffer.size());
+	}
+	else if (_ring)
+	{
+		_write(0, _count);
+	}
+	else
+	{
+		_write(0, _count % _buffer.size());
+	}
+
+	if (_file && std::fclose(_file) != 0)
+		std::cout << "WARNING:  Cannot write trace, tracing stopped" << std::endl;
+}
+
+bool SearchTracer::is_open() const
+{
+	return _file;
+}
+
+void SearchTracer::record(const TraceRecord & record)
+{
+	if (!_file)
+		return;
+
+	_buffer[_count++ % _buffer.size()] = record;
+
+	if (!_ring && _count % _buffer.size() == 0)
+		_write(0, _buffer.size());
+}
+
+/*
+ * Writes buffered records. A failed write, such as on a full disk, closes the
+ * file and stops tracing rather than leaving a trace with records missing
+ * from the middle.
+ */
+void SearchTracer::_write(size_t begin, size_t end)
+{
+	unsigned char bytes[RECORD_SIZE];
+
+	for (size_t i = begin; i < end && _file; i++)
+	{
+		const TraceRecord & record = _buffer[i];
+
+		_put_u32(bytes, record.positions);
+		_put_u16(bytes + 4, record.alpha);
+		_put_u16(bytes + 6, record.beta);
+		_put_u16(bytes + 8, record.score);
+		_put_u16(bytes + 10, record.moves);
+		_put_u16(bytes + 12, record.searched);
+		_put_u16(bytes + 14, record.best);
+
+		bytes[16] = record.depth;
+		bytes[17] = record.empty;
+		bytes[18] = record.flags;
+		bytes[19] = record.square;
+		bytes[20] = record.card;
+		bytes[21] = 0;
+
+		if (std::fwrite(bytes, RECORD_SIZE, 1, _file) != 1)
+		{
+			std::cout << "WARNING:  Cannot write trace, tracing stopped" << std::endl;
+			std::fclose(_file);
+			_file = nullptr;
+		}
+	}
+}
+
+/*
+ * Totals for the nodes with a given number of empty squares.
+ */
+struct TraceSummary
+{
+	TraceSummary() :
+		nodes(0),
+		table_hits(0),
+		bounds(0),
+		moves(0),
+		searched(0),
+		cutoffs(0),
+		first_cutoffs(0),
+		hash_moves(0),
+		hash_cutoffs(0),
+		best_index(0),
+		best_nodes(0),
+		positions(0)
+	{ }
+
+	long nodes;
+	long table_hits;
+	long bounds;
+	long moves;
+	long searched;
+	long cutoffs;
+	long first_cutoffs;
+	long hash_moves;
+	long hash_cutoffs;
+	long best_index;
+	long best_nodes;
+	long positions;
+};
+
+static double _ratio(long numerator, long denominator)
+{
+	return denominator > 0 ? static_cast<double>(numerator) / denominator : 0.0;
+}
+
+/*
+ * Summarizes a trace by empty squares: how often nodes are settled by a table
+ * hit or by the margin bounds, the average number of legal and searched moves
+ * (the effective branching factor), how often nodes cut off and how often on
+ * the first move tried, how often a hash move was available and produced the
+ * cutoff, and the average search-order index of the best move. The nodes with
+ * the largest subtrees are listed at the end.
+ */
+int trace_main(const std::vector<std::string> & arguments)
+{
+	if (arguments.size() < 2)
+	{
+		std::cout << "ERROR:    No trace file given" << std::endl;
+		return 1;
+	}
+
+	std::FILE * file = std::fopen(arguments[1].c_str(), "rb");
+	unsigned char header[FILE_HEADER_SIZE];
+
+	if (!file || std::fread(header, FILE_HEADER_SIZE, 1, file) != 1 || std::memcmp(header, FILE_MAGIC, 8) != 0 || _get_u32(header + 8) != VERSION || _get_u32(header + 12) != SearchTracer::RECORD_SIZE)
+	{
+		std::cout << "ERROR:    Cannot read trace " << arguments[1] << std::endl;
+
+		if (file)
+			std::fclose(file);
+
+		return 1;
+	}
+
+	std::vector<TraceSummary> summaries(256);
+	std::vector<TraceRecord> largest;
+
+	unsigned char bytes[SearchTracer::RECORD_SIZE];
+
+	while (std::fread(bytes, SearchTracer::RECORD_SIZE, 1, file) == 1)
+	{
+		TraceRecord record;
+
+		record.positions = _get_u32(bytes);
+		record.alpha = _get_u16(bytes + 4);
+		record.beta = _get_u16(bytes + 6);
+		record.score = _get_u16(bytes + 8);
+		record.moves = _get_u16(bytes + 10);
+		record.searched = _get_u16(bytes + 12);
+		record.best = _get_u16(bytes + 14);
+		record.depth = bytes[16];
+		record.empty = bytes[17];
+		record.flags = bytes[18];
+		record.square = bytes[19];
+		record.card = bytes[20];
+
+		TraceSummary & summary = summaries[record.empty];
+
+		summary.nodes++;
+		summary.positions += record.positions;
+
+		if (record.flags & TRACE_TABLE_HIT)
+		{
+			summary.table_hits++;
+			continue;
+		}
+
+		if (record.flags & TRACE_BOUND)
+		{
+			summary.bounds++;
+			continue;
+		}
+
+		summary.moves += record.moves;
+		summary.searched += record.searched;
+
+		if (record.flags & TRACE_HASH_MOVE)
+			summary.hash_moves++;
+
+		if (record.flags & TRACE_CUTOFF)
+		{
+			summary.cutoffs++;
+
+			if (record.best == 0)
+			{
+				summary.first_cutoffs++;
+
+				if (record.flags & TRACE_HASH_MOVE)
+					summary.hash_cutoffs++;
+			}
+		}
+
+		if (record.best != 65535)
+		{
+			summary.best_index += record.best;
+			summary.best_nodes++;
+		}
+
+		largest.push_back(record);
+		std::push_heap(largest.begin(), largest.end(), [](const TraceRecord & a, const TraceRecord & b) { return a.positions > b.positions; });
+
+		if (largest.size() > 10)
+		{
+			std::pop_heap(largest.begin(), largest.end(), [](const TraceRecord & a, const TraceRecord & b) { return a.positions > b.positions; });
+			largest.pop_back();
+		}
+	}
+
+	std::fclose(file);
+
+	std::cout << std::left << std::fixed << std::setprecision(3);
+
+	for (int empty = summaries.size() - 1; empty >= 0; empty--)
+	{
+		const TraceSummary & summary = summaries[empty];
+
+		if (summary.nodes == 0)
+			continue;
+
+		long searched_nodes = summary.nodes - summary.table_hits - summary.bounds;
+
+		std::cout << "TRACE:    ";
+		std::cout << std::setw(7) << "Empty:" << std::setw(4) << empty;
+		std::cout << std::setw(7) << "Nodes:" << std::setw(12) << summary.nodes;
+		std::cout << std::setw(6) << "Hits:" << std::setw(8) << _ratio(summary.table_hits, summary.nodes);
+		std::cout << std::setw(8) << "Bounds:" << std::setw(8) << _ratio(summary.bounds, summary.nodes);
+		std::cout << std::setw(7) << "Moves:" << std::setw(8) << _ratio(summary.moves, searched_nodes);
+		std::cout << std::setw(10) << "Searched:" << std::setw(8) << _ratio(summary.searched, searched_nodes);
+		std::cout << std::setw(9) << "Cutoffs:" << std::setw(8) << _ratio(summary.cutoffs, searched_nodes);
+		std::cout << std::setw(7) << "First:" << std::setw(8) << _ratio(summary.first_cutoffs, summary.cutoffs);
+		std::cout << std::setw(6) << "Hash:" << std::setw(8) << _ratio(summary.hash_cutoffs, summary.hash_moves);
+		std::cout << std::setw(6) << "Best:" << std::setw(8) << _ratio(summary.best_index, summary.best_nodes);
+		std::cout << std::setw(10) << "Subtree:" << std::setw(10) << std::setprecision(1) << _ratio(summary.positions, summary.nodes) << std::setprecision(3);
+		std::cout << std::endl;
+	}
+
+	std::sort(largest.begin(), largest.end(), [](const TraceRecord & a, const TraceRecord & b) { return a.positions > b.positions; });
+
+	for (auto & record : largest)
+	{
+		std::cout << "LARGEST:  ";
+		std::cout << std::setw(11) << "Positions:" << std::setw(12) << record.positions;
+		std::cout << std::setw(7) << "Empty:" << std::setw(4) << static_cast<int>(record.empty);
+		std::cout << std::setw(8) << "Window:" << std::setw(14) << ("(" + std::to_string(record.alpha) + ", " + std::to_string(record.beta) + ")");
+		std::cout << std::setw(7) << "Score:" << std::setw(6) << record.score;
+		std::cout << std::setw(10) << "Searched:" << std::setw(4) << static_cast<int>(record.searched) << "/ " << std::setw(4) << static_cast<int>(record.moves);
+		std::cout << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_TRACE_HH
+#define TRIPLETRIAD_TRACE_HH
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+ * One searched node, written when the search leaves it. Scores are from the
+ * perspective of the searching player, in the units of Board::find_move.
+ * Nodes settled by a table entry or by the margin bounds without searching
+ * any moves are flagged TRACE_TABLE_HIT or TRACE_BOUND.
+ */
+struct TraceRecord
+{
+	uint32_t positions;
+
+	int16_t alpha;
+	int16_t beta;
+	int16_t score;
+
+	uint16_t moves;
+	uint16_t searched;
+	uint16_t best;
+
+	uint8_t depth;
+	uint8_t empty;
+	uint8_t flags;
+
+	uint8_t square;
+	uint8_t card;
+};
+
+enum TraceFlag
+{
+	TRACE_MAXIMIZING = 1,
+	TRACE_CUTOFF = 2,
+	TRACE_HASH_MOVE = 4,
+	TRACE_TABLE_HIT = 8,
+	TRACE_BOUND = 16
+};
+
+/*
+ * Records search nodes to a binary file, for the summary printed by
+ * "tripletriad trace FILE". The searches only call the tracer when built with
+ * TRIPLETRIAD_TRACE defined; otherwise the hooks are compiled out entirely.
+ *
+ * The file is a 16 byte header, "TTTRACE" and a zero byte followed by the
+ * version and record size (u32), and then 22 byte records: positions searched
+ * below the node (u32); alpha, beta and the result (i16); legal moves, moves
+ * searched and the search-order index of the best or cutoff move (u16, 65535
+ * if none); remaining depth, empty squares, flags and the best move's square
+ * and card (u8); and a zero byte. A 5x5 board has up to 325 legal moves, so
+ * the counts need 16 bits. All integers are little-endian.
+ *
+ * With a sampling rate of N, only nodes whose hash falls in one of N buckets
+ * are kept. In ring mode, only the last records that fit in the buffer are
+ * kept, and they are written when the tracer is destroyed; otherwise the
+ * buffer is written out whenever it fills.
+ */
+class SearchTracer
+{
+	public:
+		SearchTracer(const std::string & path, int sample_rate, size_t buffer_records, bool ring);
+		~SearchTracer();
+
+		bool is_open() const;
+
+		bool sample(uint64_t hash) const;
+		void record(const TraceRecord & record);
+
+		static const int RECORD_SIZE = 22;
+
+	private:
+		void _write(size_t begin, size_t end);
+
+		std::FILE * _file;
+
+		int _sample_rate;
+		bool _ring;
+
+		std::vector<TraceRecord> _buffer;
+		size_t _count;
+};
+
+inline bool SearchTracer::sample(uint64_t hash) const
+{
+	return _file && (_sample_rate <= 1 || (hash >> 32) % _sample_rate == 0);
+}
+
+int trace_main(const std::vector<std::string> & arguments);
+
+#endif
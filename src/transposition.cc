@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <new>
+
+#include <sys/mman.h>
+
+#include "transposition.hh"
+
+/* Data word fields, eight bits each from the lowest. */
+enum Field
+{
+	FIELD_LOWER,
+	FIELD_UPPER,
+	FIELD_SQUARE,
+	FIELD_CARD,
+	FIELD_DEPTH,
+	FIELD_GENERATION
+};
+
+static int _get_field(uint64_t data, Field field)
+{
+	return static_cast<int8_t>(data >> (8 * field));
+}
+
+static uint64_t _load(const uint64_t & word)
+{
+	return __atomic_load_n(&word, __ATOMIC_RELAXED);
+}
+
+static void _store(uint64_t & word, uint64_t value)
+{
+	__atomic_store_n(&word, value, __ATOMIC_RELAXED);
+}
+
+/*
+ * Allocates 2^bits entries. The memory is mapped directly, and with huge_pages
+ * the kernel is asked to back it with transparent huge pages, which cuts TLB
+ * misses for large tables.
+ */
+TranspositionTable::TranspositionTable(int bits, bool huge_pages) :
+	_slots(nullptr),
+	_size(get_size(bits)),
+	_mask((static_cast<uint64_t>(1) << (std::max(bits, 2) - 2)) - 1),
+	_generation(0)
+{
+	void * memory = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (memory == MAP_FAILED)
+		throw std::bad_alloc();
+
+#ifdef MADV_HUGEPAGE
+	if (huge_pages)
+		madvise(memory, _size, MADV_HUGEPAGE);
+#else
+	(void)huge_pages;
+#endif
+
+	_slots = static_cast<Slot *>(memory);
+}
+
+TranspositionTable::~TranspositionTable()
+{
+	munmap(_slots, _size);
+}
+
+bool TranspositionTable::probe(uint64_t key, int & lower, int & upper, int & square, int & card) const
+{
+	const Slot * bucket = _slots + (key & _mask) * BUCKET_SLOTS;
+
+	for (int i = 0; i < BUCKET_SLOTS; i++)
+	{
+		uint64_t data = _load(bucket[i].data);
+
+		if ((_load(bucket[i].check) ^ data) != key)
+			continue;
+
+		lower = _get_field(data, FIELD_LOWER);
+		upper = _get_field(data, FIELD_UPPER);
+		square = _get_field(data, FIELD_SQUARE);
+		card = _get_field(data, FIELD_CARD);
+
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * Stores bounds for a position. Bounds already held for the same position are
+ * merged in, and so is its best move if none is given.
+ */
+void TranspositionTable::store(uint64_t key, int depth, int lower, int upper, int square, int card)
+{
+	Slot * bucket = _slots + (key & _mask) * BUCKET_SLOTS;
+	Slot * target = nullptr;
+
+	int generation = _generation.load(std::memory_order_relaxed) & 0x7f;
+	int lowest = 0;
+
+	for (int i = 0; i < BUCKET_SLOTS; i++)
+	{
+		uint64_t data = _load(bucket[i].data);
+		uint64_t check = _load(bucket[i].check);
+
+		if ((check ^ data) == key)
+		{
+			target = bucket + i;
+
+			lower = std::max(lower, _get_field(data, FIELD_LOWER));
+			upper = std::min(upper, _get_field(data, FIELD_UPPER));
+
+			if (square < 0)
+			{
+				square = _get_field(data, FIELD_SQUARE);
+				card = _get_field(data, FIELD_CARD);
+			}
+
+			depth = std::max(depth, _get_field(data, FIELD_DEPTH));
+
+			break;
+		}
+
+		int value = check == 0 && data == 0 ? -1 : _get_field(data, FIELD_DEPTH) + (_get_field(data, FIELD_GENERATION) == generation ? 128 : 0);
+
+		if (!target || value < lowest)
+		{
+			target = bucket + i;
+			lowest = value;
+		}
+	}
+
+	uint64_t data = _pack(lower, upper, square, card, depth, generation);
+
+	_store(target->check, key ^ data);
+	_store(target->data, data);
+}
+
+/*
+ * Empties the table. Not safe while other threads are using it.
+ */
+void TranspositionTable::clear()
+{
+	for (size_t i = 0; i < (_mask + 1) * BUCKET_SLOTS; i++)
+	{
+		_store(_slots[i].check, 0);
+		_store(_slots[i].data, 0);
+	}
+}
+
+/*
+ * Marks the entries stored so far as belonging to an earlier search, so that
+ * new positions replace them first.
+ */
+void TranspositionTable::next_generation()
+{
+	_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*
+ * The number of bytes a table of 2^bits entries maps.
+ */
+size_t TranspositionTable::get_size(int bits)
+{
+	return (static_cast<size_t>(1) << std::max(bits, 2)) * sizeof(Slot);
+}
+
+uint64_t TranspositionTable::_pack(int lower, int upper, int square, int card, int depth, int generation)
+{
+	uint64_t data = 0;
+
+	data |= static_cast<uint64_t>(static_cast<uint8_t>(lower)) << (8 * FIELD_LOWER);
+	data |= static_cast<uint64_t>(static_cast<uint8_t>(upper)) << (8 * FIELD_UPPER);
+	data |= static_cast<uint64_t>(static_cast<uint8_t>(square)) << (8 * FIELD_SQUARE);
+	data |= static_cast<uint64_t>(static_cast<uint8_t>(card)) << (8 * FIELD_CARD);
+	data |= static_cast<uint64_t>(static_cast<uint8_t>(depth)) << (8 * FIELD_DEPTH);
+	data |= static_cast<uint64_t>(static_cast<uint8_t>(generation)) << (8 * FIELD_GENERATION);
+
+	return data;
+}
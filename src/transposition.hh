@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_TRANSPOSITION_HH
+#define TRIPLETRIAD_TRANSPOSITION_HH
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Cache of search results keyed by position hash. Each entry holds a lower and
+ * an upper bound on the value of the position from the perspective of the
+ * player to move, along with the best move found (as square and card indices)
+ * and the number of empty squares below it.
+ *
+ * The table is lock-free and may be shared by any number of searching threads.
+ * An entry is stored as a data word and the key XORed with that word, two plain
+ * words read and written with relaxed atomic builtins, so the zeroed memory
+ * the table maps needs no construction. An entry torn by concurrent stores no
+ * longer verifies and reads as a miss. Entries are grouped in cache-line buckets of four, and a
+ * new position replaces the shallowest entry, preferring ones left over from
+ * earlier generations. Searches do not start generations themselves; the
+ * drivers start one per game, or per round of games across the threads
+ * sharing a table, so that entries age over games rather than searches.
+ */
+class TranspositionTable
+{
+	public:
+		TranspositionTable(int bits, bool huge_pages);
+		~TranspositionTable();
+
+		bool probe(uint64_t key, int & lower, int & upper, int & square, int & card) const;
+		void store(uint64_t key, int depth, int lower, int upper, int square, int card);
+
+		void clear();
+		void next_generation();
+
+		static size_t get_size(int bits);
+
+	private:
+		struct Slot
+		{
+			uint64_t check;
+			uint64_t data;
+		};
+
+		static const int BUCKET_SLOTS = 4;
+
+		static uint64_t _pack(int lower, int upper, int square, int card, int depth, int generation);
+
+		Slot * _slots;
+		size_t _size;
+
+		uint64_t _mask;
+
+		std::atomic<int> _generation;
+};
+
+#endif
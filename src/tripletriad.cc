@@ -20,12 +20,23 @@
  * SOFTWARE.
  */
 
+#include <chrono>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <string>
 
 #include "board.hh"
 #include "common.hh"
+#include "deck.hh"
+#include "export.hh"
+#include "selfplay.hh"
+#include "shard.hh"
+#include "tournament.hh"
+#include "verify.hh"
+#include "trace.hh"
+#include "perft.hh"
+#include "replay.hh"
 
 std::vector<std::string> get_input()
 {
@@ -58,11 +69,110 @@ std::vector<std::string> get_input()
 	return tokens;
 }
 
+std::string format_utility(int score, bool exact)
+{
+	std::ostringstream utility;
+
+	if (exact)
+		utility << score;
+	else
+		utility << std::fixed << std::setprecision(2) << static_cast<double>(score) / Evaluator::SCALE;
+
+	return utility.str();
+}
+
+/*
+ * Searches for at most the given number of seconds, printing progress every
+ * quarter of a second, and returns the best of the root moves searched in time. Waiting on
+ * the search here keeps the board untouched until it has finished or unwound.
+ * If no root move was searched in time, a one ply search decides instead.
+ */
+std::shared_ptr<Move> suggest_timed_move(Board & board, int depth, double seconds, const std::string & label)
+{
+	bool exact = depth >= board.get_empty_count();
+
+	auto printed = std::chrono::steady_clock::now();
+
+	auto control = std::make_shared<SearchControl>([exact, printed](const SearchProgress & progress) mutable {
+		if (progress.complete || progress.cancelled || std::chrono::steady_clock::now() - printed < std::chrono::milliseconds(250))
+			return;
+
+		printed = std::chrono::steady_clock::now();
+
+		std::cout << std::left << "PROGRESS: ";
+		std::cout << std::setw(11) << "Positions:" << std::setw(12) << progress.positions;
+		std::cout << std::setw(7) << "Moves:" << std::setw(8) << (std::to_string(progress.searched_moves) + "/" + std::to_string(progress.total_moves));
+
+		if (progress.best_move)
+		{
+			std::cout << std::setw(6) << "Move:" << std::setw(30) << *progress.best_move;
+			std::cout << std::setw(10) << "Utility:" << std::setw(10) << format_utility(progress.best_score, exact);
+		}
+
+		std::cout << std::endl;
+	});
+
+	auto future = board.find_move_async(depth, control);
+
+	if (future.wait_for(std::chrono::duration<double>(seconds)) != std::future_status::ready)
+		control->cancel();
+
+	auto best_move = future.get();
+	SearchProgress progress = control->get_progress();
+
+	if (!best_move)
+		best_move = progress.best_move;
+
+	if (!best_move)
+		return board.suggest_move(1);
+
+	std::cout << std::left << label;
+	std::cout << std::setw(11) << "Positions:" << std::setw(12) << progress.positions;
+	std::cout << std::setw(6) << "Move:" << std::setw(30) << *best_move;
+	std::cout << std::setw(10) << "Utility:" << std::setw(10) << format_utility(progress.best_score, exact);
+	std::cout << std::setw(7) << "Moves:" << std::setw(8) << (std::to_string(progress.searched_moves) + "/" + std::to_string(progress.total_moves));
+	std::cout << std::endl;
+
+	return best_move;
+}
+
 int main(int argc, char ** argv)
 {
+	std::vector<std::string> arguments(argv + 1, argv + argc);
+
+	if (!arguments.empty() && arguments[0] == "selfplay")
+		return selfplay_main(arguments);
+
+	if (!arguments.empty() && arguments[0] == "export")
+		return export_main(arguments);
+
+	if (!arguments.empty() && arguments[0] == "deck")
+		return deck_main(arguments);
+
+	if (!arguments.empty() && arguments[0] == "shard")
+		return shard_main(arguments);
+
+	if (!arguments.empty() && arguments[0] == "tournament")
+		return tournament_main(arguments);
+
+	if (!arguments.empty() && arguments[0] == "verify")
+		return verify_main(arguments);
+
+	if (!arguments.empty() && arguments[0] == "trace")
+		return trace_main(arguments);
+
+	if (!arguments.empty() && arguments[0] == "perft")
+		return perft_main(arguments);
+
+	if (!arguments.empty() && arguments[0] == "replay")
+		return replay_main(arguments);
+
 	std::shared_ptr<Board> board;
 	std::vector<bool> human(2);
 
+	int depth = 0;
+	double seconds = 0.0;
+
 	bool run = true;
 	bool started = false;
 
@@ -105,6 +215,58 @@ int main(int argc, char ** argv)
 					if (!board->move(move, true))
 						std::cout << "Invalid move, Captain. Try again." << std::endl;
 				}
+				else if (tokens[0] == "analyze" && tokens.size() > 1 && tokens[1] == "outcomes")
+				{
+					for (auto & entry : board->analyze_outcomes())
+					{
+						std::cout << std::left << "ANALYSIS: ";
+						std::cout << std::setw(6) << "Move:" << std::setw(30) << *(entry.move);
+						std::cout << std::setw(10) << "Outcome:" << (entry.outcome == OUTCOME_WIN ? "Win" : (entry.outcome == OUTCOME_DRAW ? "Draw" : "Loss"));
+						std::cout << std::endl;
+					}
+				}
+				else if (tokens[0] == "analyze")
+				{
+					bool exact = tokens.size() < 2 || tokens[1] != "bounds";
+
+					for (auto & entry : board->analyze_moves(exact))
+					{
+						std::ostringstream utility;
+						utility << (entry.bound == BOUND_UPPER ? "<= " : "") << entry.score;
+
+						std::cout << std::left << "ANALYSIS: ";
+						std::cout << std::setw(6) << "Move:" << std::setw(30) << *(entry.move);
+						std::cout << std::setw(10) << "Utility:" << std::setw(10) << utility.str();
+						std::cout << std::endl;
+					}
+				}
+				else if (tokens[0] == "hint")
+				{
+					double hint_seconds = 10.0;
+
+					if (tokens.size() > 1)
+					{
+						std::istringstream seconds_stream(tokens[1]);
+						seconds_stream >> hint_seconds;
+					}
+
+					suggest_timed_move(*board, depth > 0 ? depth : board->get_empty_count(), hint_seconds, "HINT:     ");
+				}
+				else if (tokens[0] == "outcome")
+				{
+					Outcome outcome = board->solve_outcome();
+
+					std::cout << "OUTCOME:  " << (outcome == OUTCOME_WIN ? "Win" : (outcome == OUTCOME_DRAW ? "Draw" : "Loss")) << std::endl;
+				}
+				else if (tokens[0] == "encode")
+				{
+					Position position;
+
+					if (board->encode(position))
+						std::cout << "POSITION: " << position << std::endl;
+					else
+						std::cout << "WARNING:  Position cannot be encoded" << std::endl;
+				}
 				else if (tokens[0] == "exit")
 				{
 					run = false;
@@ -112,7 +274,12 @@ int main(int argc, char ** argv)
 			}
 			else
 			{
-				auto move = board->suggest_move();
+				std::shared_ptr<Move> move;
+
+				if (seconds > 0.0)
+					move = suggest_timed_move(*board, depth > 0 ? depth : board->get_empty_count(), seconds, "COMPUTER: ");
+				else
+					move = depth > 0 ? board->suggest_move(depth) : board->suggest_move();
 
 				board->move(move, true);
 			}
@@ -193,6 +360,40 @@ int main(int argc, char ** argv)
 				if (!board->activate_card(player, name))
 					std::cout << "WARNING:  Invalid card" << std::endl;
 			}
+			else if (tokens[0] == "position")
+			{
+				Position position;
+
+				if (tokens.size() < 2 || !Position::parse(tokens[1], position) || !board->decode(position))
+					std::cout << "WARNING:  Invalid position" << std::endl;
+			}
+			else if (tokens[0] == "depth" && tokens.size() > 1)
+			{
+				std::istringstream depth_stream(tokens[1]);
+				depth_stream >> depth;
+			}
+			else if (tokens[0] == "time" && tokens.size() > 1)
+			{
+				std::istringstream seconds_stream(tokens[1]);
+				seconds_stream >> seconds;
+			}
+			else if (tokens[0] == "trace" && tokens.size() > 1)
+			{
+				int sample_rate = 1;
+
+				if (tokens.size() > 2)
+				{
+					std::istringstream rate_stream(tokens[2]);
+					rate_stream >> sample_rate;
+				}
+
+				auto tracer = std::make_shared<SearchTracer>(tokens[1], sample_rate, 65536, false);
+
+				if (!tracer->is_open())
+					std::cout << "WARNING:  Cannot open trace file" << std::endl;
+				else if (!board->set_tracer(tracer))
+					std::cout << "WARNING:  Tracing requires building with TRIPLETRIAD_TRACE" << std::endl;
+			}
 			else if (tokens[0] == "start")
 			{
 				started = true;
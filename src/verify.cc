@@ -0,0 +1,563 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "dealer.hh"
+#include "options.hh"
+#include "verify.hh"
+
+static const int MAXIMUM_REPORTS = 10;
+
+VerifyResult::VerifyResult() :
+	positions(0),
+	mismatches(0),
+	optimized_seconds(0.0),
+	reference_seconds(0.0)
+{ }
+
+void VerifyResult::merge(const VerifyResult & other)
+{
+	positions += other.positions;
+	mismatches += other.mismatches;
+	optimized_seconds += other.optimized_seconds;
+	reference_seconds += other.reference_seconds;
+}
+
+Verifier::Verifier(int minimum_level, int maximum_level, bool elemental, int minimum_empty, int maximum_empty, unsigned int seed, int size, bool outcomes) :
+	_minimum_level(minimum_level),
+	_maximum_level(maximum_level),
+	_elemental(elemental),
+	_minimum_empty(minimum_empty),
+	_maximum_empty(maximum_empty),
+	_seed(seed),
+	_size(size),
+	_outcomes(outcomes),
+	_reports(0)
+{ }
+
+VerifyResult Verifier::run(long positions, int threads)
+{
+	std::vector<VerifyResult> results(threads);
+	std::vector<std::thread> workers;
+
+	for (int thread = 0; thread < threads; thread++)
+		workers.push_back(std::thread(&Verifier::_run_thread, this, positions, threads, thread, std::ref(results[thread])));
+
+	VerifyResult total;
+
+	for (int thread = 0; thread < threads; thread++)
+	{
+		workers[thread].join();
+		total.merge(results[thread]);
+	}
+
+	return total;
+}
+
+void Verifier::_run_thread(long positions, int threads, int thread, VerifyResult & result)
+{
+	if (_size == 5)
+		_run_plain<5, 5>(positions, threads, thread, result);
+	else if (_size == 4)
+		_run_plain<4, 4>(positions, threads, thread, result);
+	else
+		_run_reference(positions, threads, thread, result);
+}
+
+/*
+ * Each position is generated from its own seed, so a reported position can be
+ * found again with any number of threads.
+ */
+void Verifier::_run_reference(long positions, int threads, int thread, VerifyResult & result)
+{
+	Board board(PLAYER_RED, _elemental);
+	Dealer dealer(board, _minimum_level, _maximum_level, _elemental);
+	ReferenceSolver reference(board.get_cards());
+
+	VerifyResult local;
+
+	std::vector<std::shared_ptr<Card>> hands[2];
+	std::vector<ReferenceMove> moves[2];
+
+	for (long index = thread; index < positions; index += threads)
+	{
+		std::seed_seq sequence{_seed, static_cast<unsigned int>(index), static_cast<unsigned int>(index >> 32)};
+		std::mt19937 random(sequence);
+
+		board.get_transposition_table()->next_generation();
+		dealer.deal(board, random, hands);
+
+		int empty = std::uniform_int_distribution<int>(_minimum_empty, _maximum_empty)(random);
+
+		while (board.get_empty_count() > empty)
+		{
+			auto legal = board.get_moves();
+			board.move(legal[std::uniform_int_distribution<size_t>(0, legal.size() - 1)(random)], false);
+		}
+
+		Position position;
+		board.encode(position);
+
+		auto start = std::chrono::steady_clock::now();
+		_solve(board, position, moves[0]);
+		auto middle = std::chrono::steady_clock::now();
+
+		long reference_positions = 0;
+		_solve_reference(reference, position, moves[1], reference_positions);
+		auto end = std::chrono::steady_clock::now();
+
+		local.positions++;
+		local.optimized_seconds += std::chrono::duration<double>(middle - start).count();
+		local.reference_seconds += std::chrono::duration<double>(end - middle).count();
+
+		bool same = moves[0].size() == moves[1].size();
+
+		for (size_t i = 0; same && i < moves[0].size(); i++)
+			same = moves[0][i].square == moves[1][i].square && moves[0][i].card == moves[1][i].card && moves[0][i].score == moves[1][i].score;
+
+		if (!same)
+		{
+			local.mismatches++;
+			_report(board, reference, position, _minimize(board, reference, position));
+		}
+	}
+
+	result = local;
+}
+
+/*
+ * The same positions as _run_reference, on a larger board. Only the number of
+ * empty squares bounds the plain search, so the range should be small.
+ */
+template <int Rows, int Columns>
+void Verifier::_run_plain(long positions, int threads, int thread, VerifyResult & result)
+{
+	BasicBoard<Rows, Columns> board(PLAYER_RED, _elemental);
+	BasicDealer<Rows, Columns> dealer(board, _minimum_level, _maximum_level, _elemental);
+
+	VerifyResult local;
+
+	std::vector<std::shared_ptr<Card>> hands[2];
+	std::vector<ReferenceMove> moves[2];
+
+	for (long index = thread; index < positions; index += threads)
+	{
+		std::seed_seq sequence{_seed, static_cast<unsigned int>(index), static_cast<unsigned int>(index >> 32)};
+		std::mt19937 random(sequence);
+
+		board.get_transposition_table()->next_generation();
+		dealer.deal(board, random, hands);
+
+		int empty = std::uniform_int_distribution<int>(_minimum_empty, _maximum_empty)(random);
+
+		while (board.get_empty_count() > empty)
+		{
+			auto legal = board.get_moves();
+			board.move(legal[std::uniform_int_distribution<size_t>(0, legal.size() - 1)(random)], false);
+		}
+
+		auto snapshot = board.snapshot();
+
+		auto start = std::chrono::steady_clock::now();
+		_analyze(board, moves[0]);
+		auto middle = std::chrono::steady_clock::now();
+
+		long reference_positions = 0;
+		board.restore(snapshot);
+		_solve_plain(board, moves[1], reference_positions);
+		auto end = std::chrono::steady_clock::now();
+
+		if (_outcomes)
+			_reduce_to_outcomes(moves[1]);
+
+		local.positions++;
+		local.optimized_seconds += std::chrono::duration<double>(middle - start).count();
+		local.reference_seconds += std::chrono::duration<double>(end - middle).count();
+
+		bool same = moves[0].size() == moves[1].size();
+
+		for (size_t i = 0; same && i < moves[0].size(); i++)
+			same = moves[0][i].square == moves[1][i].square && moves[0][i].card == moves[1][i].card && moves[0][i].score == moves[1][i].score;
+
+		if (!same)
+		{
+			local.mismatches++;
+			_report_plain(board.get_cards(), Columns, index, moves);
+		}
+	}
+
+	result = local;
+}
+
+/*
+ * Scores every legal move with the optimized search, in the same order as the
+ * reference solver. In outcome mode the scores are -1, 0 and 1, and they are
+ * preceded by the outcome of the position, with a square and card of -1.
+ */
+template <int Rows, int Columns>
+void Verifier::_analyze(BasicBoard<Rows, Columns> & board, std::vector<ReferenceMove> & moves)
+{
+	moves.clear();
+
+	if (_outcomes && board.get_empty_count() > 0)
+	{
+		ReferenceMove whole;
+		whole.square = -1;
+		whole.card = -1;
+		whole.score = static_cast<int>(board.solve_outcome()) - OUTCOME_DRAW;
+
+		moves.push_back(whole);
+
+		for (auto & entry : board.analyze_outcomes())
+		{
+			ReferenceMove move;
+			move.square = entry.move->square->index;
+			move.card = entry.move->card->index;
+			move.score = static_cast<int>(entry.outcome) - OUTCOME_DRAW;
+
+			moves.push_back(move);
+		}
+	}
+	else if (!_outcomes)
+	{
+		for (auto & entry : board.analyze_moves(true))
+		{
+			ReferenceMove move;
+			move.square = entry.move->square->index;
+			move.card = entry.move->card->index;
+			move.score = entry.score;
+
+			moves.push_back(move);
+		}
+	}
+
+	std::sort(moves.begin(), moves.end(), [](const ReferenceMove & a, const ReferenceMove & b) {
+		return a.square != b.square ? a.square < b.square : a.card < b.card;
+	});
+}
+
+/*
+ * Scores every legal move by plain minimax, restoring a snapshot before each
+ * move rather than undoing it.
+ */
+template <int Rows, int Columns>
+void Verifier::_solve_plain(BasicBoard<Rows, Columns> & board, std::vector<ReferenceMove> & moves, long & positions)
+{
+	moves.clear();
+
+	auto snapshot = board.snapshot();
+	size_t count = board.get_moves().size();
+
+	for (size_t i = 0; i < count; i++)
+	{
+		board.restore(snapshot);
+
+		auto move = board.get_moves()[i];
+		Player player = board.get_current_player();
+
+		ReferenceMove entry;
+		entry.square = move->square->index;
+		entry.card = move->card->index;
+
+		board.move(move, false);
+		positions++;
+
+		if (board.get_empty_count() == 0)
+		{
+			entry.score = board.get_score(player) - board.get_score(player == PLAYER_RED ? PLAYER_BLUE : PLAYER_RED);
+		}
+		else
+		{
+			std::vector<ReferenceMove> replies;
+			_solve_plain(board, replies, positions);
+
+			entry.score = -replies[0].score;
+
+			for (auto & reply : replies)
+				entry.score = std::min(entry.score, -reply.score);
+		}
+
+		moves.push_back(entry);
+	}
+
+	board.restore(snapshot);
+
+	std::sort(moves.begin(), moves.end(), [](const ReferenceMove & a, const ReferenceMove & b) {
+		return a.square != b.square ? a.square < b.square : a.card < b.card;
+	});
+}
+
+bool Verifier::_solve(Board & board, const Position & position, std::vector<ReferenceMove> & moves)
+{
+	moves.clear();
+
+	if (!board.decode(position))
+		return false;
+
+	_analyze(board, moves);
+
+	return true;
+}
+
+void Verifier::_solve_reference(const ReferenceSolver & reference, const Position & position, std::vector<ReferenceMove> & moves, long & positions)
+{
+	reference.solve(position, moves, positions);
+
+	if (_outcomes)
+		_reduce_to_outcomes(moves);
+}
+
+/*
+ * Turns the scores from a reference into the form _analyze gives in outcome
+ * mode.
+ */
+void Verifier::_reduce_to_outcomes(std::vector<ReferenceMove> & moves)
+{
+	if (moves.empty())
+		return;
+
+	ReferenceMove whole;
+	whole.square = -1;
+	whole.card = -1;
+	whole.score = -1;
+
+	for (auto & move : moves)
+	{
+		move.score = (move.score > 0) - (move.score < 0);
+		whole.score = std::max(whole.score, move.score);
+	}
+
+	moves.insert(moves.begin(), whole);
+}
+
+bool Verifier::_differs(Board & board, const ReferenceSolver & reference, const Position & position)
+{
+	std::vector<ReferenceMove> moves[2];
+	long positions = 0;
+
+	_solve(board, position, moves[0]);
+	_solve_reference(reference, position, moves[1], positions);
+
+	if (moves[0].size() != moves[1].size())
+		return true;
+
+	for (size_t i = 0; i < moves[0].size(); i++)
+	{
+		if (moves[0][i].square != moves[1][i].square || moves[0][i].card != moves[1][i].card || moves[0][i].score != moves[1][i].score)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Repeatedly replaces the position with a simpler one that still differs:
+ * one with a square's element cleared, or one move further into the game.
+ */
+Position Verifier::_minimize(Board & board, const ReferenceSolver & reference, const Position & position)
+{
+	Position minimal = position;
+	bool reduced = true;
+
+	while (reduced)
+	{
+		reduced = false;
+
+		std::vector<Position> candidates;
+
+		board.decode(minimal);
+
+		for (int square = 0; square < 9 && _elemental; square++)
+		{
+			board.decode(minimal);
+			board.set_element(square / 3, square % 3, ELEMENT_NONE);
+
+			Position candidate;
+
+			if (board.encode(candidate) && candidate != minimal)
+				candidates.push_back(candidate);
+		}
+
+		board.decode(minimal);
+		auto moves = board.get_moves();
+
+		for (size_t i = 0; i < moves.size(); i++)
+		{
+			board.decode(minimal);
+			board.move(board.get_moves()[i], false);
+
+			Position candidate;
+
+			if (board.encode(candidate))
+				candidates.push_back(candidate);
+		}
+
+		for (auto & candidate : candidates)
+		{
+			if (_differs(board, reference, candidate))
+			{
+				minimal = candidate;
+				reduced = true;
+				break;
+			}
+		}
+	}
+
+	return minimal;
+}
+
+void Verifier::_report(Board & board, const ReferenceSolver & reference, const Position & position, const Position & minimal)
+{
+	std::vector<ReferenceMove> moves[2];
+	long positions = 0;
+
+	_solve(board, minimal, moves[0]);
+	_solve_reference(reference, minimal, moves[1], positions);
+
+	std::lock_guard<std::mutex> lock(_output_mutex);
+
+	if (++_reports > MAXIMUM_REPORTS)
+		return;
+
+	std::cout << std::left << "MISMATCH: ";
+	std::cout << std::setw(10) << "Position:" << std::setw(34) << position;
+	std::cout << std::setw(9) << "Minimal:" << std::setw(34) << minimal;
+	std::cout << std::endl;
+
+	_print_moves(board.get_cards(), 3, moves);
+}
+
+/*
+ * Positions on larger boards have no encoding, so they are reported by the
+ * index that, with the seed, deals them again.
+ */
+void Verifier::_report_plain(const std::vector<std::shared_ptr<Card>> & cards, int columns, long index, const std::vector<ReferenceMove> moves[2])
+{
+	std::lock_guard<std::mutex> lock(_output_mutex);
+
+	if (++_reports > MAXIMUM_REPORTS)
+		return;
+
+	std::cout << std::left << "MISMATCH: ";
+	std::cout << std::setw(7) << "Index:" << std::setw(12) << index;
+	std::cout << std::setw(6) << "Seed:" << std::setw(12) << _seed;
+	std::cout << std::endl;
+
+	_print_moves(cards, columns, moves);
+}
+
+void Verifier::_print_moves(const std::vector<std::shared_ptr<Card>> & cards, int columns, const std::vector<ReferenceMove> moves[2])
+{
+	for (size_t i = 0; i < std::max(moves[0].size(), moves[1].size()); i++)
+	{
+		std::cout << std::left << "MOVE:     ";
+
+		for (int engine = 0; engine < 2; engine++)
+		{
+			std::cout << std::setw(11) << (engine == 0 ? "Optimized:" : "Reference:");
+
+			if (i >= moves[engine].size())
+				std::cout << std::setw(33) << "-";
+			else if (moves[engine][i].square < 0)
+				std::cout << std::setw(27) << "Position" << std::setw(6) << moves[engine][i].score;
+			else
+				std::cout << "(" << moves[engine][i].square / columns + 1 << ", " << moves[engine][i].square % columns + 1 << ") " << std::setw(20) << cards[moves[engine][i].card]->name << std::setw(6) << moves[engine][i].score;
+		}
+
+		std::cout << std::endl;
+	}
+}
+
+int verify_main(const std::vector<std::string> & arguments)
+{
+	long positions = 100000;
+	int minimum_empty = 1;
+	int maximum_empty = 6;
+	bool elemental = false;
+	bool outcomes = false;
+	bool empty_given = false;
+	unsigned int seed = 1;
+	int size = 3;
+
+	BatchOptions options;
+
+	for (size_t i = 1; i < arguments.size(); i++)
+	{
+		if (options.parse(arguments, i))
+			continue;
+
+		if (arguments[i] == "elemental")
+			elemental = true;
+		else if (arguments[i] == "outcomes")
+			outcomes = true;
+		else if (i + 1 >= arguments.size())
+			break;
+		else if (arguments[i] == "positions")
+			positions = std::atol(arguments[++i].c_str());
+		else if (arguments[i] == "empty")
+			empty_given = std::sscanf(arguments[++i].c_str(), "%d-%d", &minimum_empty, &maximum_empty) > 0;
+		else if (arguments[i] == "seed")
+			seed = std::atoi(arguments[++i].c_str());
+		else if (arguments[i] == "size")
+			size = std::atoi(arguments[++i].c_str());
+	}
+
+	if (!options.check())
+		return 1;
+
+	if (size < 3 || size > 5)
+	{
+		std::cout << "ERROR:    Board size must be 3, 4 or 5" << std::endl;
+		return 1;
+	}
+
+	/* The plain search on larger boards is only practical near the end. */
+	if (size > 3 && !empty_given)
+		maximum_empty = 4;
+
+	minimum_empty = std::max(0, std::min(size * size, minimum_empty));
+	maximum_empty = std::max(minimum_empty, std::min(size * size, maximum_empty));
+
+	Verifier verifier(options.minimum_level, options.maximum_level, elemental, minimum_empty, maximum_empty, seed, size, outcomes);
+
+	auto start = std::chrono::steady_clock::now();
+	auto result = verifier.run(positions, options.threads);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << std::left << std::fixed << "VERIFY:   ";
+	std::cout << std::setw(11) << "Positions:" << std::setw(12) << result.positions;
+	std::cout << std::setw(12) << "Mismatches:" << std::setw(8) << result.mismatches;
+	std::cout << std::setw(11) << "Optimized:" << std::setw(10) << std::setprecision(3) << result.optimized_seconds;
+	std::cout << std::setw(11) << "Reference:" << std::setw(10) << result.reference_seconds;
+	std::cout << std::setw(9) << "Speedup:" << std::setw(10) << std::setprecision(1) << result.reference_seconds / std::max(1e-9, result.optimized_seconds);
+	std::cout << std::setw(10) << "Seconds:" << std::setw(8) << std::setprecision(0) << seconds;
+	std::cout << std::endl;
+
+	return result.mismatches == 0 ? 0 : 1;
+}
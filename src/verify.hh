@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_VERIFY_HH
+#define TRIPLETRIAD_VERIFY_HH
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "board.hh"
+#include "position.hh"
+#include "reference.hh"
+
+struct VerifyResult
+{
+	VerifyResult();
+
+	void merge(const VerifyResult & other);
+
+	long positions;
+	long mismatches;
+
+	double optimized_seconds;
+	double reference_seconds;
+};
+
+/*
+ * Checks the optimized search against the reference solver on random
+ * positions: games are dealt as in self-play and played out with random moves
+ * until a random number of squares within a range are left empty. Both
+ * engines score every legal move, and the positions where any score differs
+ * are reported along with the smallest position reached from them, by playing
+ * moves and clearing elements, that still differs.
+ *
+ * In outcome mode the scores are reduced to win, draw or loss, and the
+ * optimized side uses solve_outcome for the position and analyze_outcomes for
+ * its moves. Larger boards, which the reference solver cannot read, are
+ * checked against a plain minimax over the board's own moves, restoring a
+ * snapshot for each move instead of undoing it; they are reported by index
+ * and not minimized.
+ */
+class Verifier
+{
+	public:
+		Verifier(int minimum_level, int maximum_level, bool elemental, int minimum_empty, int maximum_empty, unsigned int seed, int size, bool outcomes);
+
+		VerifyResult run(long positions, int threads);
+
+	private:
+		void _run_thread(long positions, int threads, int thread, VerifyResult & result);
+		void _run_reference(long positions, int threads, int thread, VerifyResult & result);
+
+		template <int Rows, int Columns>
+		void _run_plain(long positions, int threads, int thread, VerifyResult & result);
+
+		template <int Rows, int Columns>
+		void _analyze(BasicBoard<Rows, Columns> & board, std::vector<ReferenceMove> & moves);
+
+		template <int Rows, int Columns>
+		void _solve_plain(BasicBoard<Rows, Columns> & board, std::vector<ReferenceMove> & moves, long & positions);
+
+		bool _solve(Board & board, const Position & position, std::vector<ReferenceMove> & moves);
+		void _solve_reference(const ReferenceSolver & reference, const Position & position, std::vector<ReferenceMove> & moves, long & positions);
+		void _reduce_to_outcomes(std::vector<ReferenceMove> & moves);
+
+		bool _differs(Board & board, const ReferenceSolver & reference, const Position & position);
+		Position _minimize(Board & board, const ReferenceSolver & reference, const Position & position);
+		void _report(Board & board, const ReferenceSolver & reference, const Position & position, const Position & minimal);
+		void _report_plain(const std::vector<std::shared_ptr<Card>> & cards, int columns, long index, const std::vector<ReferenceMove> moves[2]);
+		void _print_moves(const std::vector<std::shared_ptr<Card>> & cards, int columns, const std::vector<ReferenceMove> moves[2]);
+
+		int _minimum_level;
+		int _maximum_level;
+
+		bool _elemental;
+
+		int _minimum_empty;
+		int _maximum_empty;
+
+		unsigned int _seed;
+
+		int _size;
+		bool _outcomes;
+
+		std::mutex _output_mutex;
+		int _reports;
+};
+
+int verify_main(const std::vector<std::string> & arguments);
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2013 Jason Lynch <jason@calindora.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRIPLETRIAD_ZOBRIST_HH
+#define TRIPLETRIAD_ZOBRIST_HH
+
+#include <cstdint>
+
+#include "common.hh"
+
+/*
+ * Position hash keys. Keys are derived from their arguments by a fixed mixing
+ * function rather than a random table, so they are identical across boards and
+ * across processes and need no sizing for the number of squares or cards. They
+ * are computed inline since they are used on every move made during a search.
+ *
+ * Keys are combined by addition rather than exclusive or, so that a hand holding
+ * several copies of the same card still hashes differently from one holding a
+ * single copy.
+ */
+class Zobrist
+{
+	public:
+		static uint64_t square(int square, int card, Player owner);
+		static uint64_t hand(Player player, int card);
+		static uint64_t element(int square, Element element);
+		static uint64_t player();
+		static uint64_t elemental();
+
+	private:
+		static uint64_t _mix(uint64_t value);
+};
+
+inline uint64_t Zobrist::square(int square, int card, Player owner)
+{
+	return _mix((UINT64_C(1) << 56) | (static_cast<uint64_t>(square) << 24) | (static_cast<uint64_t>(card) << 1) | owner);
+}
+
+inline uint64_t Zobrist::hand(Player player, int card)
+{
+	return _mix((UINT64_C(2) << 56) | (static_cast<uint64_t>(card) << 1) | player);
+}
+
+inline uint64_t Zobrist::element(int square, Element element)
+{
+	if (element == ELEMENT_NONE)
+		return 0;
+
+	return _mix((UINT64_C(3) << 56) | (static_cast<uint64_t>(square) << 8) | element);
+}
+
+inline uint64_t Zobrist::player()
+{
+	return _mix(UINT64_C(4) << 56);
+}
+
+inline uint64_t Zobrist::elemental()
+{
+	return _mix(UINT64_C(5) << 56);
+}
+
+inline uint64_t Zobrist::_mix(uint64_t value)
+{
+	value += UINT64_C(0x9e3779b97f4a7c15);
+	value = (value ^ (value >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+	value = (value ^ (value >> 27)) * UINT64_C(0x94d049bb133111eb);
+
+	return value ^ (value >> 31);
+}
+
+#endif